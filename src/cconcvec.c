@@ -0,0 +1,199 @@
+/*
+ * File: cconcvec.c
+ * ----------------
+ * Implementation of lock-free append-only arrays in C. Slots are
+ * reserved with an atomic fetch-and-add, buckets are installed with a
+ * compare-and-swap, and each slot has a ready flag set with release
+ * ordering once its element is written.
+ */
+
+#include "cconcvec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <stdatomic.h>
+
+// elements in the first bucket when given first_hint is 0
+#define DEFAULT_FIRST 1024
+
+// enough buckets for any int index, whatever the first bucket's size
+#define MAX_BUCKETS 33
+
+/* Type: struct CConcVectorImplementation
+ * --------------------------------------
+ * This definition completes the CConcVector type that was declared in
+ * cconcvec.h. Bucket b holds first << b elements, followed by one ready
+ * flag per element. Buckets are allocated on demand and never freed or
+ * moved until dispose.
+ */
+typedef struct CConcVectorImplementation {
+    _Atomic size_t reserved; // indexes handed out by append
+    _Atomic size_t published; // every slot below is known to be ready
+    char *_Atomic buckets[MAX_BUCKETS];
+    size_t shift; // log2 of elements in the first bucket
+    size_t elemsz;
+    CleanupElemFn clean;
+} CConcVector;
+
+
+/* Function: locate
+ * ----------------
+ * Purpose: Finds the bucket holding an index and the offset within it.
+ * Adding the first bucket's size to the index makes bucket boundaries
+ * fall at powers of two, so the bucket is the position of the top bit.
+ * Parameters: pointer to CConcVector, index, address for offset
+ * Return values: bucket number
+ */
+static size_t locate(const CConcVector *cc, size_t index, size_t *offset) {
+    size_t j = index + ((size_t)1 << cc->shift);
+    size_t top = 8 * sizeof(long) - 1 - __builtin_clzl(j);
+    *offset = j - ((size_t)1 << top);
+    return top - cc->shift;
+}
+
+static size_t bucket_size(const CConcVector *cc, size_t b) {
+    return (size_t)1 << (cc->shift + b);
+}
+
+static atomic_uchar *flags(const CConcVector *cc, char *bucket, size_t b) {
+    return (atomic_uchar *)(bucket + bucket_size(cc, b) * cc->elemsz);
+}
+
+/* Function: get_bucket
+ * --------------------
+ * Purpose: Returns a bucket, installing it if no thread has yet. Threads
+ * that race to install the same bucket each allocate one, and all but
+ * the one whose compare-and-swap succeeds free theirs and use the
+ * winner's. Flags start zeroed, as not ready.
+ * Parameters: pointer to CConcVector, bucket number
+ * Return values: pointer to bucket
+ */
+static char *get_bucket(CConcVector *cc, size_t b) {
+    char *bucket = atomic_load_explicit(&cc->buckets[b], memory_order_acquire);
+    if(bucket != NULL) return bucket;
+    char *fresh = calloc(bucket_size(cc, b), cc->elemsz + 1);
+    assert(fresh != NULL);
+    // acq_rel: publish our zeroed flags, or see the winner's
+    if(atomic_compare_exchange_strong_explicit(&cc->buckets[b], &bucket, fresh,
+                                               memory_order_acq_rel, memory_order_acquire)) {
+        return fresh;
+    }
+    free(fresh);
+    return bucket;
+}
+
+/* Function: cconcvec_create
+ * -------------------------
+ * Purpose: Allocates an empty vector with no buckets yet
+ * Parameters: element size, first bucket size hint, cleanup callback function
+ * Return values: pointer to CConcVector
+ */
+CConcVector *cconcvec_create(size_t elemsz, size_t first_hint, CleanupElemFn fn) {
+    assert(elemsz != 0);
+    CConcVector *cc = malloc(sizeof(CConcVector));
+    assert(cc != NULL);
+
+    if(first_hint == 0) first_hint = DEFAULT_FIRST;
+    cc->shift = 0;
+    while(((size_t)1 << cc->shift) < first_hint) cc->shift++;
+
+    atomic_init(&cc->reserved, 0);
+    atomic_init(&cc->published, 0);
+    for(size_t b = 0; b < MAX_BUCKETS; b++) atomic_init(&cc->buckets[b], NULL);
+    cc->elemsz = elemsz;
+    cc->clean = fn;
+    return cc;
+}
+
+/* Function: cconcvec_dispose
+ * --------------------------
+ * Purpose: Cleans published elements and frees every bucket
+ * Parameters: pointer to CConcVector
+ * Return values: void
+ */
+void cconcvec_dispose(CConcVector *cc) {
+    for(size_t b = 0; b < MAX_BUCKETS; b++) {
+        char *bucket = atomic_load_explicit(&cc->buckets[b], memory_order_acquire);
+        if(bucket == NULL) continue;
+        if(cc->clean != NULL) {
+            atomic_uchar *ready = flags(cc, bucket, b);
+            for(size_t i = 0; i < bucket_size(cc, b); i++) {
+                if(atomic_load_explicit(&ready[i], memory_order_acquire)) cc->clean(bucket + i*cc->elemsz);
+            }
+        }
+        free(bucket);
+    }
+    free(cc);
+}
+
+/* Function: cconcvec_count
+ * ------------------------
+ * Purpose: Gets number of reserved indexes
+ * Parameters: pointer to CConcVector
+ * Return values: int count
+ */
+int cconcvec_count(const CConcVector *cc) {
+    return atomic_load_explicit(&((CConcVector *)cc)->reserved, memory_order_relaxed);
+}
+
+/* Function: cconcvec_nth
+ * ----------------------
+ * Purpose: Finds a slot and checks its ready flag
+ * Parameters: pointer to CConcVector, index
+ * Return values: pointer to element, or NULL if not yet published
+ */
+void *cconcvec_nth(const CConcVector *cc, int index) {
+    CConcVector *c = (CConcVector *)cc; // atomics are loaded, never stored, here
+    // index out of bounds check
+    assert(index >= 0 && (size_t)index < atomic_load_explicit(&c->reserved, memory_order_relaxed));
+    size_t offset, b = locate(cc, index, &offset);
+    char *bucket = atomic_load_explicit(&c->buckets[b], memory_order_acquire);
+    if(bucket == NULL) return NULL; // reserved, but its appender has not installed the bucket
+    // acquire pairs with the release in append: a ready element is fully written
+    if(!atomic_load_explicit(&flags(cc, bucket, b)[offset], memory_order_acquire)) return NULL;
+    return bucket + offset*cc->elemsz;
+}
+
+/* Function: cconcvec_published
+ * ----------------------------
+ * Purpose: Advances the shared published count past every slot that has
+ * become ready since, stopping at the first that is not. Readers do this
+ * work, so appends never touch the count.
+ * Parameters: pointer to CConcVector
+ * Return values: int count of published prefix
+ */
+int cconcvec_published(CConcVector *cc) {
+    size_t n = atomic_load_explicit(&cc->published, memory_order_acquire);
+    size_t start = n, reserved = atomic_load_explicit(&cc->reserved, memory_order_relaxed);
+    while(n < reserved && cconcvec_nth(cc, n) != NULL) n++;
+    if(n == start) return n;
+    // another reader may have advanced it further; keep the larger count
+    while(!atomic_compare_exchange_weak_explicit(&cc->published, &start, n,
+                                                 memory_order_release, memory_order_acquire)) {
+        if(start >= n) return start;
+    }
+    return n;
+}
+
+/* Function: cconcvec_append
+ * -------------------------
+ * Purpose: Reserves the next index, copies the element into its slot and
+ * sets the slot's ready flag. The append that takes the middle slot of a
+ * bucket also installs the next bucket, so appends rarely find their
+ * bucket missing and race to allocate it.
+ * Parameters: pointer to CConcVector, address of element to append
+ * Return values: index of appended element
+ */
+int cconcvec_append(CConcVector *cc, const void *addr) {
+    size_t index = atomic_fetch_add_explicit(&cc->reserved, 1, memory_order_relaxed);
+    assert(index < INT_MAX);
+    size_t offset, b = locate(cc, index, &offset);
+    char *bucket = get_bucket(cc, b);
+    if(offset == bucket_size(cc, b) / 2 && b + 1 < MAX_BUCKETS) get_bucket(cc, b + 1);
+
+    memcpy(bucket + offset*cc->elemsz, addr, cc->elemsz);
+    // release: a reader that sees the flag also sees the element
+    atomic_store_explicit(&flags(cc, bucket, b)[offset], 1, memory_order_release);
+    return index;
+}
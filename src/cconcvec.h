@@ -0,0 +1,132 @@
+/* File: cconcvec.h
+ * ----------------
+ * Defines the interface for the CConcVector type.
+ *
+ * The CConcVector is an indexed, append-only collection of homogeneous
+ * elements that any number of threads may append to and read at once,
+ * without locks. Like the CSegVector, it never moves an element once
+ * stored; unlike the CSegVector, which allows only one appending thread,
+ * its appends are safe to make concurrently. An append reserves the next
+ * index with one atomic increment, so producers never wait for each
+ * other: the slot is theirs alone, and they copy their element into it
+ * while others fill other slots. Storage is a fixed directory of
+ * buckets, each twice the size of the one before, so a bucket is added
+ * only each time the vector doubles, and the directory itself never
+ * grows or moves.
+ *
+ * Because appends complete independently, an index can be reserved
+ * before the element in it is written. Each slot therefore has a flag
+ * that is set once its element is completely written (published);
+ * readers see only published elements. The slots below
+ * cconcvec_published are all published, so a reader that has seen that
+ * count can read them all in order.
+ *
+ * Disposal must wait until all appenders and readers are done.
+ */
+
+#ifndef _cconcvec_h
+#define _cconcvec_h
+
+#include "cvector.h" // CleanupElemFn
+#include <stddef.h>
+
+
+/**
+ * Type: CConcVector
+ * -----------------
+ * Defines the CConcVector type. As with the CVector, the type is
+ * incomplete; clients declare only CConcVector * pointers and manipulate
+ * the vector solely through the functions listed in this interface.
+ */
+typedef struct CConcVectorImplementation CConcVector;
+
+
+/**
+ * Function: cconcvec_create
+ * Usage: CConcVector *log = cconcvec_create(sizeof(Record), 4096, NULL)
+ * ---------------------------------------------------------------------
+ * Creates a new empty CConcVector and returns a pointer to it. The
+ * elemsz and fn parameters are as for cvec_create. The first_hint
+ * parameter is the number of elements in the first bucket; it is rounded
+ * up to a power of two, and if it is 0, an internal default is used.
+ * Each later bucket is twice as large as the one before. When done, the
+ * client must call cconcvec_dispose.
+ *
+ * Asserts: zero elemsz, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CConcVector *cconcvec_create(size_t elemsz, size_t first_hint, CleanupElemFn fn);
+
+
+/**
+ * Function: cconcvec_dispose
+ * Usage: cconcvec_dispose(log)
+ * ----------------------------
+ * Disposes of the CConcVector. Calls the client's cleanup function on
+ * each published element and deallocates all storage. No other thread
+ * may be using the CConcVector. Operates in linear-time.
+ */
+void cconcvec_dispose(CConcVector *cc);
+
+
+/**
+ * Function: cconcvec_count
+ * Usage: int count = cconcvec_count(log)
+ * --------------------------------------
+ * Returns the number of indexes reserved by appends so far. While other
+ * threads are appending, some of those indexes may not be published yet.
+ * Operates in constant-time.
+ */
+int cconcvec_count(const CConcVector *cc);
+
+
+/**
+ * Function: cconcvec_published
+ * Usage: int n = cconcvec_published(log)
+ * --------------------------------------
+ * Returns a count n such that every element at indexes 0 to n-1 has
+ * been published, so cconcvec_nth will not return NULL for any of them.
+ * Appends still in progress below the count of reserved indexes hold n
+ * back until they complete. The count never decreases, and once all
+ * appends are complete it equals cconcvec_count. Operates in
+ * constant-time plus the number of elements published since the last
+ * call by any thread.
+ */
+int cconcvec_published(CConcVector *cc);
+
+
+/**
+ * Function: cconcvec_nth
+ * Usage: Record *r = cconcvec_nth(log, 0)
+ * ---------------------------------------
+ * Accesses the element at a given index and returns a pointer to the
+ * memory location where it is stored, or NULL if the element has been
+ * reserved but is not yet published. Valid indexes are 0 to count-1; an
+ * assert is raised if index is out of bounds. The pointer remains valid,
+ * and the element unchanged, for as long as the CConcVector exists.
+ * May be called concurrently with cconcvec_append.
+ * Operates in constant-time.
+ *
+ * Asserts: invalid index
+ */
+void *cconcvec_nth(const CConcVector *cc, int index);
+
+
+/**
+ * Function: cconcvec_append
+ * Usage: int index = cconcvec_append(log, &rec)
+ * ---------------------------------------------
+ * Appends a new element, copying the value from the memory location
+ * pointed to by addr, and returns its index. Any number of threads may
+ * append at once, and each thread's elements are stored in the order it
+ * appended them; how the elements of different threads interleave is
+ * not specified. The element is published when this returns. An assert
+ * is raised on allocation failure or if the count would exceed INT_MAX.
+ * Operates in constant-time.
+ *
+ * Asserts: allocation failure, too many elements
+ * Assumes: address of valid elem
+ */
+int cconcvec_append(CConcVector *cc, const void *addr);
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * File: cgapvec.c
+ * ---------------
+ * Implementation of gap-buffer arrays in C. Storage holds the elements
+ * before the gap, then the free slots of the gap, then the elements after
+ * it; edits happen at the gap, which moves lazily to where they land.
+ */
+
+#include "cgapvec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// a suggested value to use when given capacity_hint is 0
+#define DEFAULT_CAPACITY 16
+
+/* Type: struct CGapVectorImplementation
+ * -------------------------------------
+ * This definition completes the CGapVector type that was declared in
+ * cgapvec.h. Slots gap_start to gap_end-1 are free; element i is in slot
+ * i if i < gap_start and in slot i + (gap_end - gap_start) otherwise.
+ */
+typedef struct CGapVectorImplementation {
+    void *data; // capacity slots, including the gap
+    size_t capacity;
+    size_t gap_start; // first free slot, also the index of the gap
+    size_t gap_end; // first slot after the gap
+    size_t elemsz;
+    CleanupElemFn clean;
+} CGapVector;
+
+
+/* Function: slot
+ * --------------
+ * Purpose: Performs pointer arithmetic on storage slots.
+ * Parameters: pointer to CGapVector, slot number
+ * Return values: pointer to slot
+ */
+static void *slot(const CGapVector *gv, size_t n) {
+    return (char *)gv->data + n*gv->elemsz;
+}
+
+/* Function: cgapvec_create
+ * ------------------------
+ * Purpose: Allocates an empty gap vector whose gap is all of storage.
+ * Parameters: size of each element, capacity hint, cleanup callback function
+ * Return values: pointer to CGapVector
+ */
+CGapVector *cgapvec_create(size_t elemsz, size_t capacity_hint, CleanupElemFn fn) {
+    assert(elemsz != 0);
+    if(capacity_hint == 0) capacity_hint = DEFAULT_CAPACITY;
+
+    CGapVector *gv = malloc(sizeof(CGapVector));
+    assert(gv != NULL);
+    gv->data = malloc(elemsz * capacity_hint);
+    assert(gv->data != NULL);
+    gv->capacity = capacity_hint;
+    gv->gap_start = 0;
+    gv->gap_end = capacity_hint;
+    gv->elemsz = elemsz;
+    gv->clean = fn;
+    return gv;
+}
+
+/* Function: cgapvec_dispose
+ * -------------------------
+ * Purpose: Cleans every element and frees storage.
+ * Parameters: pointer to CGapVector
+ * Return values: void
+ */
+void cgapvec_dispose(CGapVector *gv) {
+    if(gv->clean != NULL) {
+        for(int i = 0; i < cgapvec_count(gv); i++) gv->clean(cgapvec_nth(gv, i));
+    }
+    free(gv->data);
+    free(gv);
+}
+
+/* Function: cgapvec_count
+ * -----------------------
+ * Purpose: Gets number of elements, which is storage less the gap
+ * Parameters: pointer to CGapVector
+ * Return values: int count
+ */
+int cgapvec_count(const CGapVector *gv) {
+    return gv->capacity - (gv->gap_end - gv->gap_start);
+}
+
+/* Function: cgapvec_nth
+ * ---------------------
+ * Purpose: Finds an element, stepping over the gap if it lies after it
+ * Parameters: pointer to CGapVector, index
+ * Return values: pointer to element
+ */
+void *cgapvec_nth(const CGapVector *gv, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index < cgapvec_count(gv));
+    size_t n = index;
+    if(n >= gv->gap_start) n += gv->gap_end - gv->gap_start;
+    return slot(gv, n);
+}
+
+/* Function: move_gap
+ * ------------------
+ * Purpose: Moves the gap so that it starts at a given index, shifting
+ * only the elements between the old and new positions across it.
+ * Parameters: pointer to CGapVector, index
+ * Return values: void
+ */
+static void move_gap(CGapVector *gv, size_t index) {
+    size_t gaplen = gv->gap_end - gv->gap_start;
+    if(index < gv->gap_start) {
+        // elements index..gap_start-1 move up to just below gap_end
+        size_t n = gv->gap_start - index;
+        memmove(slot(gv, gv->gap_end - n), slot(gv, index), n*gv->elemsz);
+    } else if(index > gv->gap_start) {
+        // elements just after the gap move down to fill its start
+        size_t n = index - gv->gap_start;
+        memmove(slot(gv, gv->gap_start), slot(gv, gv->gap_end), n*gv->elemsz);
+    }
+    gv->gap_start = index;
+    gv->gap_end = index + gaplen;
+}
+
+/* Function: grow
+ * --------------
+ * Purpose: Doubles storage when the gap is used up. The elements after
+ * the gap move to the end of the larger storage, so the new slots all
+ * join the gap.
+ * Parameters: pointer to CGapVector
+ * Return values: void
+ */
+static void grow(CGapVector *gv) {
+    size_t capacity = gv->capacity * 2;
+    size_t after = gv->capacity - gv->gap_end;
+    gv->data = realloc(gv->data, capacity * gv->elemsz);
+    assert(gv->data != NULL);
+    memmove(slot(gv, capacity - after), slot(gv, gv->gap_end), after*gv->elemsz);
+    gv->gap_end = capacity - after;
+    gv->capacity = capacity;
+}
+
+/* Function: cgapvec_insert
+ * ------------------------
+ * Purpose: Moves the gap to index and copies the element into its first slot
+ * Parameters: pointer to CGapVector, address of element, index
+ * Return values: void
+ */
+void cgapvec_insert(CGapVector *gv, const void *addr, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index <= cgapvec_count(gv));
+    if(gv->gap_start == gv->gap_end) grow(gv);
+    move_gap(gv, index);
+    memcpy(slot(gv, gv->gap_start), addr, gv->elemsz);
+    gv->gap_start++;
+}
+
+/* Function: cgapvec_append
+ * ------------------------
+ * Purpose: Inserts an element after the last one
+ * Parameters: pointer to CGapVector, address of element
+ * Return values: void
+ */
+void cgapvec_append(CGapVector *gv, const void *addr) {
+    cgapvec_insert(gv, addr, cgapvec_count(gv));
+}
+
+/* Function: cgapvec_remove
+ * ------------------------
+ * Purpose: Moves the gap to index and absorbs the element just after it
+ * Parameters: pointer to CGapVector, index
+ * Return values: void
+ */
+void cgapvec_remove(CGapVector *gv, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index < cgapvec_count(gv));
+    if(index + 1 == gv->gap_start) {
+        // deleting backward from the gap: the gap just widens downward
+        gv->gap_start--;
+        if(gv->clean != NULL) gv->clean(slot(gv, gv->gap_start));
+        return;
+    }
+    move_gap(gv, index);
+    if(gv->clean != NULL) gv->clean(slot(gv, gv->gap_end));
+    gv->gap_end++;
+}
+
+/* Function: cgapvec_data
+ * ----------------------
+ * Purpose: Moves the gap past the last element so all elements are contiguous
+ * Parameters: pointer to CGapVector
+ * Return values: pointer to element 0
+ */
+void *cgapvec_data(CGapVector *gv) {
+    move_gap(gv, cgapvec_count(gv));
+    return gv->data;
+}
@@ -0,0 +1,146 @@
+/* File: cgapvec.h
+ * ---------------
+ * Defines the interface for the CGapVector type.
+ *
+ * The CGapVector is an indexed collection of homogeneous elements, like a
+ * CVector, tuned for many insertions and removals clustered around the
+ * same position, as in a text editor or a merge that splices runs into
+ * the middle of a sequence. A CVector keeps its elements in one block, so
+ * every insertion in the middle shifts the whole tail. A CGapVector keeps
+ * a gap of free slots inside its storage, at the position of the last
+ * edit. Inserting or removing at the gap costs only a copy; the gap is
+ * moved, shifting just the elements between its old and new positions,
+ * when an edit lands somewhere else. A run of edits near one spot is thus
+ * amortized constant-time per edit, however long the sequence.
+ *
+ * Indexing remains constant-time: elements before the gap are found
+ * directly, elements after it are offset by the gap's length.
+ */
+
+#ifndef _cgapvec_h
+#define _cgapvec_h
+
+#include "cvector.h" // CleanupElemFn
+#include <stddef.h>
+
+
+/**
+ * Type: CGapVector
+ * ----------------
+ * Defines the CGapVector type. As with the CVector, the type is
+ * incomplete; clients declare only CGapVector * pointers and manipulate
+ * the vector solely through the functions listed in this interface.
+ */
+typedef struct CGapVectorImplementation CGapVector;
+
+
+/**
+ * Function: cgapvec_create
+ * Usage: CGapVector *gv = cgapvec_create(sizeof(char), 4096, NULL)
+ * ----------------------------------------------------------------
+ * Creates a new empty CGapVector and returns a pointer to it. The elemsz,
+ * capacity_hint and fn parameters are as for cvec_create. When done, the
+ * client must call cgapvec_dispose.
+ *
+ * Asserts: zero elemsz, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CGapVector *cgapvec_create(size_t elemsz, size_t capacity_hint, CleanupElemFn fn);
+
+
+/**
+ * Function: cgapvec_dispose
+ * Usage: cgapvec_dispose(gv)
+ * --------------------------
+ * Disposes of the CGapVector. Calls the client's cleanup function on each
+ * element and deallocates all storage. Operates in linear-time.
+ */
+void cgapvec_dispose(CGapVector *gv);
+
+
+/**
+ * Function: cgapvec_count
+ * Usage: int count = cgapvec_count(gv)
+ * ------------------------------------
+ * Returns the number of elements currently stored in the CGapVector.
+ * Operates in constant-time.
+ */
+int cgapvec_count(const CGapVector *gv);
+
+
+/**
+ * Function: cgapvec_nth
+ * Usage: char ch = *(char *)cgapvec_nth(gv, 0)
+ * --------------------------------------------
+ * Accesses the element at a given index and returns a pointer to the
+ * memory location where it is stored. Valid indexes are 0 to count-1; an
+ * assert is raised if index is out of bounds. As with cvec_nth, the
+ * pointer becomes invalid during any call that adds or removes elements.
+ * Operates in constant-time.
+ *
+ * Asserts: invalid index
+ */
+void *cgapvec_nth(const CGapVector *gv, int index);
+
+
+/**
+ * Function: cgapvec_insert
+ * Usage: cgapvec_insert(gv, &elem, 10)
+ * ------------------------------------
+ * Inserts a copy of the element at addr so that it ends up at the given
+ * index, shifting up the elements after it. The gap is first moved to
+ * the index, which costs time proportional to the distance from the
+ * previous edit; the copy into the gap is then constant-time. When the
+ * gap is used up, storage is doubled. An assert is raised if index is
+ * less than 0 or greater than the count, or on allocation failure.
+ * Operates in constant-time (amortized) when index is at or next to the
+ * previous edit.
+ *
+ * Asserts: invalid index, allocation failure
+ * Assumes: address of valid elem
+ */
+void cgapvec_insert(CGapVector *gv, const void *addr, int index);
+
+
+/**
+ * Function: cgapvec_append
+ * Usage: cgapvec_append(gv, &elem)
+ * --------------------------------
+ * Appends a copy of the element at addr to the end of the CGapVector,
+ * the same as cgapvec_insert at index count.
+ *
+ * Asserts: allocation failure
+ * Assumes: address of valid elem
+ */
+void cgapvec_append(CGapVector *gv, const void *addr);
+
+
+/**
+ * Function: cgapvec_remove
+ * Usage: cgapvec_remove(gv, 3)
+ * ----------------------------
+ * Removes the element at the given index, shifting down the elements
+ * after it. The client's cleanup function is called on the removed
+ * element. The gap is moved to the index and widened by one slot, so
+ * removing repeatedly at or just before the previous edit (forward or
+ * backward delete) is constant-time. An assert is raised if index is
+ * less than 0 or greater than the count minus one.
+ *
+ * Asserts: invalid index
+ */
+void cgapvec_remove(CGapVector *gv, int index);
+
+
+/**
+ * Function: cgapvec_data
+ * Usage: char *text = cgapvec_data(gv)
+ * ------------------------------------
+ * Moves the gap to the end of storage so that all elements are
+ * contiguous in index order, and returns a pointer to element 0. As with
+ * cvec_data, the pointer becomes invalid during any call that adds or
+ * removes elements. Operates in time proportional to the number of
+ * elements after the gap.
+ */
+void *cgapvec_data(CGapVector *gv);
+
+#endif
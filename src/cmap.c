@@ -7,15 +7,31 @@
  */
 
 #include "cmap.h"
+#include "cstrpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/random.h>
 
 // a suggested value to use when given capacity_hint is 0
 #define DEFAULT_CAPACITY 1023
 
+// value slots in a new multimap blob, doubled as values are appended
+#define MULTI_CAPACITY 4
+
+// operation counters are compiled in only on request (-DCMAP_STATS)
+#ifdef CMAP_STATS
+#define CMAP_COUNT(cm, field) (((CMap *)(cm))->ops.field++)
+#else
+#define CMAP_COUNT(cm, field) ((void)0)
+#endif
+
 /* Type: struct CMapImplementation
  * -------------------------------
  * This definition completes the CMap type that was declared in
@@ -27,28 +43,131 @@ typedef struct CMapImplementation {
     size_t valsz;
     int count;
     CleanupValueFn clean;
+    size_t hdrsz; // bytes of pointers in front of each blob's key
+    bool multi; // blobs hold a growable run of values per key
+    CStrPool *pool; // interns keys if not NULL, owned by client
+    int max_entries; // bound on count for LRU maps, 0 if unbounded
+    void *lru_head, *lru_tail; // most and least recently used blobs
+    CMapHashKind hashkind;
+    uint64_t seed[2]; // per-map secret, random unless set by client
+#ifdef CMAP_STATS
+    struct {
+        unsigned long lookups, hits, misses, probes;
+    } ops; // bumped through const pointers by cmap_get, see CMAP_COUNT
+#endif
 } CMap;
 
 
+/* Function: hash_fast
+ * -------------------
+ * A seeded variant of FNV-1a: the 64-bit code starts from the per-map
+ * seed instead of the FNV offset basis, and each character is xor'ed in
+ * and then multiplied by the 64-bit FNV prime. Starting from the seed
+ * makes which keys collide depend on the map, so they cannot be
+ * precomputed from the algorithm alone. A final step xors in the second
+ * seed word and applies a murmur3-style finalizer, folding the high bits
+ * down before the modulo. This makes bucket placement unpredictable
+ * across maps and runs, but it is not a keyed PRF; tables exposed to
+ * adversarial keys should use SipHash. The hash is case-sensitive.
+ */
+static uint64_t hash_fast(const char *s, const uint64_t seed[2]) {
+    const uint64_t MULTIPLIER = 0x100000001b3ULL; // magic number (64-bit FNV prime)
+    uint64_t hashcode = seed[0];
+    for (int i = 0; s[i] != '\0'; i++)
+        hashcode = (hashcode ^ (unsigned char)s[i]) * MULTIPLIER;
+    hashcode ^= seed[1];
+    hashcode ^= hashcode >> 33;
+    hashcode *= 0xff51afd7ed558ccdULL;
+    hashcode ^= hashcode >> 33;
+    return hashcode;
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND                                                \
+    do {                                                        \
+        v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32); \
+        v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2;                   \
+        v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0;                   \
+        v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32); \
+    } while(0)
+
+/* Function: hash_siphash
+ * ----------------------
+ * SipHash-2-4 (Aumasson & Bernstein) of the key string under the map's
+ * 128-bit secret. Without the secret an attacker cannot predict which
+ * keys collide, so chains stay short even for hostile input. Roughly
+ * 2-3x the cost of hash_fast for short keys.
+ */
+static uint64_t hash_siphash(const char *s, const uint64_t k[2]) {
+    size_t len = strlen(s);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ k[1];
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *end = p + (len & ~(size_t)7);
+
+    for(; p != end; p += 8) {
+        uint64_t m = 0;
+        for(int i = 0; i < 8; i++) m |= (uint64_t)p[i] << (8 * i); // little-endian load
+        v3 ^= m;
+        SIPROUND;
+        SIPROUND;
+        v0 ^= m;
+    }
+
+    // last block holds the remaining bytes and the length in its top byte
+    uint64_t b = (uint64_t)len << 56;
+    for(size_t i = 0; i < (len & 7); i++) b |= (uint64_t)p[i] << (8 * i);
+    v3 ^= b;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
 /* Function: hash
  * --------------
- * This function adapted from Eric Roberts' _The Art and Science of C_
- * It takes a string and uses it to derive a "hash code," which
- * is an integer in the range [0-nbuckets-1]. The hash code is computed
- * using a method called "linear congruence." A similar function using this
- * method is described on page 144 of Kernighan and Ritchie. The choice of
- * the value for the multiplier can have a significant effort on the
- * performance of the algorithm, but not on its correctness.
- * The computed hash value is stable, e.g. passing the same string and
- * nbuckets to function again will always return the same code.
- * The hash is case-sensitive.
- */
-static int hash(const char *s, int nbuckets) {
-   const unsigned long MULTIPLIER = 2630849305L; // magic number
-   unsigned long hashcode = 0;
-   for (int i = 0; s[i] != '\0'; i++)
-      hashcode = hashcode * MULTIPLIER + s[i];
-   return hashcode % nbuckets;
+ * Purpose: Maps a key to its bucket using the map's hash function and seed.
+ * The computed value is stable for a given map, e.g. passing the same
+ * string again will always return the same bucket.
+ * Parameters: pointer to CMap, key string
+ * Return values: bucket index in the range [0-nbuckets-1]
+ */
+static int hash(const CMap *cm, const char *s) {
+    uint64_t hashcode;
+    if(cm->pool != NULL) {
+        // an interned key is the only copy of its string, so its address is
+        // its identity; hashkind does not apply, only the seed
+        hashcode = ((uintptr_t)s ^ cm->seed[0]) * 0x9e3779b97f4a7c15ULL;
+        hashcode ^= hashcode >> 32;
+    } else if(cm->hashkind == CMAP_HASH_SIPHASH) {
+        hashcode = hash_siphash(s, cm->seed);
+    } else {
+        hashcode = hash_fast(s, cm->seed);
+    }
+    return hashcode % cm->nbuckets;
+}
+
+/* Function: random_seed
+ * ---------------------
+ * Purpose: Draws a fresh 128-bit seed from the kernel. If the entropy
+ * source is unavailable, falls back to mixing the clock with an address
+ * so maps still get distinct (if guessable) seeds.
+ * Parameters: seed array to fill, address to mix into the fallback
+ * Return values: void
+ */
+static void random_seed(uint64_t seed[2], const void *salt) {
+    if(getrandom(seed, 2 * sizeof(uint64_t), 0) == 2 * sizeof(uint64_t)) return;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    seed[0] = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ (uintptr_t)salt;
+    seed[1] = (seed[0] ^ 0x9e3779b97f4a7c15ULL) * 0xbf58476d1ce4e5b9ULL;
 }
 
 /* Function: get_next
@@ -71,36 +190,104 @@ void set_next(void *blob, void *ptr_to_next) {
     *(void **)blob = ptr_to_next;
 }
 
+/* Function: get_lru_prev / get_lru_next
+ * --------------------------------------
+ * Purpose: Gets the neighbours of a blob in an LRU map's recency list.
+ * The two links sit right after the chain pointer, see cmap_create_lru.
+ * Parameters: pointer to current blob
+ * Return values: pointer to more/less recently used blob, or NULL
+ */
+void *get_lru_prev(const void *blob) {
+    return ((void **)blob)[1];
+}
+
+void *get_lru_next(const void *blob) {
+    return ((void **)blob)[2];
+}
+
+/* Function: set_lru_links
+ * -----------------------
+ * Purpose: Sets both recency links of a blob in an LRU map
+ * Parameters: pointer to current blob, more recent blob, less recent blob
+ * Return values: void
+ */
+void set_lru_links(void *blob, void *prev, void *next) {
+    ((void **)blob)[1] = prev;
+    ((void **)blob)[2] = next;
+}
+
 /* Function: get_key
  * -----------------
  * Purpose: Gets pointer to key in blob
- * Parameters: pointer to current blob
+ * Parameters: pointer to CMap, pointer to current blob
  * Return values: char * where key is stored
  */
-char *get_key(void *blob) {
-    // returns pointer to key
-    return (char *)blob + sizeof(void *);
+char *get_key(const CMap *cm, void *blob) {
+    // key follows the pointers at the front of the blob, interned keys are stored by pointer
+    if(cm->pool != NULL) return *(char **)((char *)blob + cm->hdrsz);
+    return (char *)blob + cm->hdrsz;
 }
 
 /* Function: set_key
  * ------------------
  * Purpose: Sets pointer to key in blob
- * Parameters: pointer to current blob, char * key to add
+ * Parameters: pointer to CMap, pointer to current blob, char * key to add
  * Return values: void
  */
-void set_key(void *blob, const char *key) {
-    // memcpy(get_key(blob), key, sizeof(key));
-    strcpy(get_key(blob), key);
+void set_key(const CMap *cm, void *blob, const char *key) {
+    if(cm->pool != NULL) *(const char **)((char *)blob + cm->hdrsz) = key;
+    else strcpy(get_key(cm, blob), key);
+}
+
+/* Function: key_matches
+ * ---------------------
+ * Purpose: Compares the key of a blob with a search key. Keys of a map
+ * using a CStrPool are canonical, so equal keys are equal pointers.
+ * Parameters: pointer to CMap, pointer to blob, search key
+ * Return values: true if the keys are the same
+ */
+bool key_matches(const CMap *cm, void *blob, const char *key) {
+    if(cm->pool != NULL) return get_key(cm, blob) == key;
+    return strcmp(get_key(cm, blob), key) == 0;
+}
+
+/* Function: values_offset
+ * -----------------------
+ * Purpose: Computes where the value field starts for a key of given length.
+ * In a multimap the key is followed by a size_t-aligned [count][capacity]
+ * header, then the values packed back to back. An interned key takes the
+ * space of one pointer whatever its length.
+ * Parameters: pointer to CMap, length of key
+ * Return values: byte offset of value field from start of blob
+ */
+size_t values_offset(const CMap *cm, size_t keylen) {
+    size_t off = cm->hdrsz + (cm->pool != NULL ? sizeof(char *) : keylen + 1); // +1 for null term
+    if(cm->multi) {
+        off = (off + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+        off += 2 * sizeof(size_t);
+    }
+    return off;
 }
 
 /* Function: get_value
  * -------------------
  * Purpose: Gets pointer to value field in blob
- * Parameters: pointer to current blob
+ * Parameters: pointer to CMap, pointer to current blob
  * Return values: pointer to value field in blob
  */
-void *get_value(void *blob) {
-    return (char *)blob + sizeof(void *) + strlen(get_key(blob)) + 1; 
+void *get_value(const CMap *cm, void *blob) {
+    size_t keylen = (cm->pool != NULL) ? 0 : strlen(get_key(cm, blob));
+    return (char *)blob + values_offset(cm, keylen);
+}
+
+/* Function: get_multi_header
+ * --------------------------
+ * Purpose: Gets the [count][capacity] pair in front of a multimap's values
+ * Parameters: pointer to CMap, pointer to current blob
+ * Return values: pointer to the two size_t fields
+ */
+size_t *get_multi_header(const CMap *cm, void *blob) {
+    return (size_t *)get_value(cm, blob) - 2;
 }
 
 /* Function: set_value
@@ -109,28 +296,107 @@ void *get_value(void *blob) {
  * Parameters: pointer to CMap, pointer to current blob, address of value to add
  * Return values: void
  */
-void set_value(CMap *cm, void *blob, const void *value) {
-    memcpy(get_value(blob), value, cm->valsz); 
+void set_value(const CMap *cm, void *blob, const void *value) {
+    memcpy(get_value(cm, blob), value, cm->valsz); 
+}
+
+/* Function: blob_size
+ * -------------------
+ * Purpose: Computes the allocation size of a blob for a given key
+ * Parameters: pointer to CMap, key string, number of value slots
+ * Return values: number of bytes
+ */
+size_t blob_size(const CMap *cm, const char *key, size_t nvalues) {
+    size_t keylen = (cm->pool != NULL) ? 0 : strlen(key);
+    return values_offset(cm, keylen) + nvalues * cm->valsz;
 }
 
 /* Function: create_blob
  * ---------------------
- * Purpose: Creates a blob with a next pointer, key, and value
- * Parameters: pointer to CMap, address of key and value
+ * Purpose: Creates a blob with a next pointer, key, and n values (n is 1
+ * unless the map is a multimap, where it may also be 0 or more)
+ * Parameters: pointer to CMap, address of key and values, number of values
  * Return values: pointer to blob
  */
-void *create_blob(CMap *cm, const char *key, const void *value) {
+void *create_blob(CMap *cm, const char *key, const void *values, size_t n) {
+    size_t nvalues = cm->multi ? (n > MULTI_CAPACITY ? n : MULTI_CAPACITY) : 1;
     // ptr_to_next will always be NULL
-    void *blob = malloc(sizeof(void *) + strlen(key) + 1 + cm->valsz); // +1 for null term
+    void *blob = malloc(blob_size(cm, key, nvalues));
     // assert if allocation fails
     assert(blob != NULL);
 
     set_next(blob, NULL);
-    set_key(blob, key);
-    set_value(cm, blob, value);
+    set_key(cm, blob, key);
+    if(cm->multi) {
+        size_t *header = get_multi_header(cm, blob);
+        header[0] = n;
+        header[1] = nvalues;
+    }
+    if(n > 0) memcpy(get_value(cm, blob), values, n * cm->valsz);
     return blob;
 }
 
+/* Function: clean_values
+ * ----------------------
+ * Purpose: Calls the client's cleanup function on every value of a blob
+ * Parameters: pointer to CMap, pointer to blob
+ * Return values: void
+ */
+void clean_values(const CMap *cm, void *blob) {
+    if(cm->clean == NULL) return;
+    size_t n = cm->multi ? get_multi_header(cm, blob)[0] : 1;
+    char *value = get_value(cm, blob);
+    for(size_t i = 0; i < n; i++) cm->clean(value + i * cm->valsz);
+}
+
+/* Function: lru_unlink
+ * --------------------
+ * Purpose: Takes a blob out of the recency list of an LRU map
+ * Parameters: pointer to CMap, pointer to blob
+ * Return values: void
+ */
+void lru_unlink(CMap *cm, void *blob) {
+    void *prev = get_lru_prev(blob), *next = get_lru_next(blob);
+    if(prev != NULL) set_lru_links(prev, get_lru_prev(prev), next);
+    else cm->lru_head = next;
+    if(next != NULL) set_lru_links(next, prev, get_lru_next(next));
+    else cm->lru_tail = prev;
+}
+
+/* Function: lru_push_front
+ * ------------------------
+ * Purpose: Makes a blob the most recently used entry of an LRU map
+ * Parameters: pointer to CMap, pointer to blob (not currently in the list)
+ * Return values: void
+ */
+void lru_push_front(CMap *cm, void *blob) {
+    set_lru_links(blob, NULL, cm->lru_head);
+    if(cm->lru_head != NULL) set_lru_links(cm->lru_head, blob, get_lru_next(cm->lru_head));
+    else cm->lru_tail = blob;
+    cm->lru_head = blob;
+}
+
+/* Function: lru_evict
+ * -------------------
+ * Purpose: Removes the least recently used entry, cleaning its value.
+ * The bucket chain is singly linked, so the blob's predecessor is found
+ * by walking its bucket (constant-time on average for a sized table).
+ * Parameters: pointer to CMap
+ * Return values: void
+ */
+void lru_evict(CMap *cm) {
+    void *victim = cm->lru_tail;
+    lru_unlink(cm, victim);
+
+    void **link = &cm->buckets[hash(cm, get_key(cm, victim))];
+    while(*link != victim) link = (void **)*link; // chain pointer is first field
+    *link = get_next(victim);
+
+    clean_values(cm, victim);
+    free(victim);
+    (cm->count)--;
+}
+
 /* Function: cmap_create
  * ---------------------
  * Purpose: Allocates memory for a map and initializes fields.
@@ -151,6 +417,16 @@ CMap *cmap_create(size_t valuesz, size_t capacity_hint, CleanupValueFn fn) {
     cm->count = 0;
 
     cm->clean = fn;
+    cm->hdrsz = sizeof(void *);
+    cm->multi = false;
+    cm->pool = NULL;
+    cm->max_entries = 0;
+    cm->lru_head = cm->lru_tail = NULL;
+    cm->hashkind = CMAP_HASH_FAST;
+    random_seed(cm->seed, cm);
+#ifdef CMAP_STATS
+    memset(&cm->ops, 0, sizeof(cm->ops));
+#endif
     // calloc because that everything is automatically NULL'd out (as in spec drawings)
     // you only know if you have a non-empty bucket if it's NULL
     cm->buckets = calloc(capacity_hint, sizeof(void *));
@@ -160,6 +436,67 @@ CMap *cmap_create(size_t valuesz, size_t capacity_hint, CleanupValueFn fn) {
     return cm;
 }
 
+/* Function: cmap_create_lru
+ * -------------------------
+ * Purpose: Allocates a map bounded to max_entries that evicts the least
+ * recently used entry. Blobs carry two extra recency links after the
+ * chain pointer: [next][lru prev][lru next][key\0][value].
+ * Parameters: size of map values, entry bound, cleanup callback function
+ * Return values: pointer to CMap
+ */
+CMap *cmap_create_lru(size_t valuesz, size_t max_entries, CleanupValueFn fn) {
+    // the bound is compared with the int count, so it must fit in one
+    assert(max_entries > 0 && max_entries <= INT_MAX);
+    // table sized for the bound, it never holds more
+    CMap *cm = cmap_create(valuesz, max_entries, fn);
+    cm->hdrsz = 3 * sizeof(void *);
+    cm->max_entries = max_entries;
+    return cm;
+}
+
+/* Function: cmap_create_multi
+ * ---------------------------
+ * Purpose: Allocates a map whose keys each own a contiguous run of values
+ * stored in the key's blob.
+ * Parameters: size of map values, capacity, cleanup callback function
+ * Return values: pointer to CMap
+ */
+CMap *cmap_create_multi(size_t valuesz, size_t capacity_hint, CleanupValueFn fn) {
+    CMap *cm = cmap_create(valuesz, capacity_hint, fn);
+    cm->multi = true;
+    return cm;
+}
+
+/* Function: cmap_set_hash
+ * -----------------------
+ * Purpose: Selects the hash function and seed of an empty map.
+ * Parameters: pointer to CMap, hash kind, 16-byte seed or NULL for random
+ * Return values: void
+ */
+void cmap_set_hash(CMap *cm, CMapHashKind kind, const void *seed) {
+    // entries already placed would be in the wrong buckets
+    assert(cm->count == 0);
+    assert(kind == CMAP_HASH_FAST || kind == CMAP_HASH_SIPHASH);
+    cm->hashkind = kind;
+    if(seed != NULL) memcpy(cm->seed, seed, sizeof(cm->seed));
+    else random_seed(cm->seed, cm);
+}
+
+/* Function: cmap_intern_keys
+ * --------------------------
+ * Purpose: Makes an empty map store its keys as canonical pool strings.
+ * Parameters: pointer to CMap, pointer to CStrPool
+ * Return values: void
+ */
+void cmap_intern_keys(CMap *cm, CStrPool *pool) {
+    // blobs already holding copied keys would be misread
+    assert(cm->count == 0);
+    assert(pool != NULL);
+    // the pool cannot release keys the LRU evicts, so it would grow without bound
+    assert(cm->max_entries == 0);
+    cm->pool = pool;
+}
+
 /* Function: cmap_dispose
  * ----------------------
  * Purpose: Cleans up values and frees buckets and map.
@@ -174,9 +511,7 @@ void cmap_dispose(CMap *cm) {
             void *blob = cm->buckets[i];
             cm->buckets[i] = get_next(blob);
             // call cleanup function on values
-            if(cm->clean != NULL) {
-                cm->clean(get_value(blob));
-            }
+            clean_values(cm, blob);
             free(blob);
         }
     }
@@ -203,28 +538,39 @@ int cmap_count(const CMap *cm) {
  * Return values: void
  */
 void cmap_put(CMap *cm, const char *key, const void *addr) { 
+    if(cm->pool != NULL) key = cstrpool_intern(cm->pool, key);
     // hash the key to get bucket number
-    int bucket_num = hash(key, cm->nbuckets);
+    int bucket_num = hash(cm, key);
     
     // loop through linked list to check if key already exists
     // starting point is pointer to first blob
+    CMAP_COUNT(cm, lookups);
     void *temp = cm->buckets[bucket_num];
     while(temp != NULL) {
+        CMAP_COUNT(cm, probes);
         // check if key already exists
-        if(strcmp(get_key(temp), key) == 0) {
-            if(cm->clean != NULL) {
-                // call cleanup function on old value
-                cm->clean(get_value(temp));
-            }
+        if(key_matches(cm, temp, key)) {
+            CMAP_COUNT(cm, hits);
+            // call cleanup function on old value(s)
+            clean_values(cm, temp);
+            // a multimap key is left with just the new value
+            if(cm->multi) get_multi_header(cm, temp)[0] = 1;
             // replace without incrementing count
             set_value(cm, temp, addr); 
+            if(cm->max_entries > 0) {
+                lru_unlink(cm, temp);
+                lru_push_front(cm, temp);
+            }
             return;
         }
         temp = get_next(temp);
     }
     
     // if key is new create blob
-    void *blob = create_blob(cm, key, addr);
+    CMAP_COUNT(cm, misses);
+    if(cm->max_entries > 0 && cm->count == cm->max_entries) lru_evict(cm);
+    void *blob = create_blob(cm, key, addr, 1);
+    if(cm->max_entries > 0) lru_push_front(cm, blob);
     
     // add to front of linked list (instead of back for Big-O)
     void *start = cm->buckets[bucket_num];
@@ -244,21 +590,188 @@ void cmap_put(CMap *cm, const char *key, const void *addr) {
  * Return values: pointer to key of interest
  */
 void *cmap_get(const CMap *cm, const char *key) { 
-    int bucket_num = hash(key, cm->nbuckets);
+    // a string the pool has never seen cannot be a key
+    if(cm->pool != NULL && (key = cstrpool_lookup(cm->pool, key)) == NULL) {
+        CMAP_COUNT(cm, lookups);
+        CMAP_COUNT(cm, misses);
+        return NULL;
+    }
+    int bucket_num = hash(cm, key);
 
     // loop through linked list to find key
+    CMAP_COUNT(cm, lookups);
     void *temp = cm->buckets[bucket_num];
     while(temp != NULL) {
-        if(strncmp(get_key(temp), key, strlen(key)) == 0) {
-            return get_value(temp);
+        CMAP_COUNT(cm, probes);
+        // full compare, a prefix match is not the same key
+        if(key_matches(cm, temp, key)) {
+            CMAP_COUNT(cm, hits);
+            if(cm->max_entries > 0 && temp != cm->lru_head) {
+                // recency is bookkeeping, not part of the map's logical state
+                lru_unlink((CMap *)cm, temp);
+                lru_push_front((CMap *)cm, temp);
+            }
+            return get_value(cm, temp);
         }
         temp = get_next(temp);
     }
     
     // if not found
+    CMAP_COUNT(cm, misses);
     return NULL;
 }
 
+/* Function: cmap_append
+ * ---------------------
+ * Purpose: Adds a value to the end of a key's run in a multimap, creating
+ * the key if needed. A full blob is realloc'ed to twice its value slots
+ * and relinked into its chain through the link that pointed to it.
+ * Parameters: pointer to CMap, key, address of value
+ * Return values: void
+ */
+void cmap_append(CMap *cm, const char *key, const void *addr) {
+    assert(cm->multi);
+    if(cm->pool != NULL) key = cstrpool_intern(cm->pool, key);
+    int bucket_num = hash(cm, key);
+    void **link = &cm->buckets[bucket_num];
+
+    CMAP_COUNT(cm, lookups);
+    while(*link != NULL && !key_matches(cm, *link, key)) {
+        CMAP_COUNT(cm, probes);
+        link = (void **)*link; // chain pointer is first field
+    }
+
+    if(*link == NULL) {
+        CMAP_COUNT(cm, misses);
+        void *blob = create_blob(cm, key, addr, 1);
+        set_next(blob, cm->buckets[bucket_num]);
+        cm->buckets[bucket_num] = blob;
+        (cm->count)++;
+        return;
+    }
+
+    CMAP_COUNT(cm, probes);
+    CMAP_COUNT(cm, hits);
+    void *blob = *link;
+    size_t *header = get_multi_header(cm, blob);
+    if(header[0] == header[1]) {
+        blob = realloc(blob, blob_size(cm, key, 2 * header[1]));
+        assert(blob != NULL);
+        *link = blob;
+        header = get_multi_header(cm, blob);
+        header[1] *= 2;
+    }
+    memcpy((char *)get_value(cm, blob) + header[0] * cm->valsz, addr, cm->valsz);
+    header[0]++;
+}
+
+/* Function: cmap_put_all
+ * ----------------------
+ * Purpose: Replaces a multimap key's values with a run of n values,
+ * creating the key if needed. The old values are cleaned, and a blob too
+ * small for the new run is realloc'ed to exactly n value slots and
+ * relinked into its chain through the link that pointed to it.
+ * Parameters: pointer to CMap, key, address of first value, number of values
+ * Return values: void
+ */
+void cmap_put_all(CMap *cm, const char *key, const void *values, int n) {
+    assert(cm->multi);
+    assert(n >= 0);
+    if(cm->pool != NULL) key = cstrpool_intern(cm->pool, key);
+    int bucket_num = hash(cm, key);
+    void **link = &cm->buckets[bucket_num];
+
+    CMAP_COUNT(cm, lookups);
+    while(*link != NULL && !key_matches(cm, *link, key)) {
+        CMAP_COUNT(cm, probes);
+        link = (void **)*link; // chain pointer is first field
+    }
+
+    if(*link == NULL) {
+        CMAP_COUNT(cm, misses);
+        void *blob = create_blob(cm, key, values, n);
+        set_next(blob, cm->buckets[bucket_num]);
+        cm->buckets[bucket_num] = blob;
+        (cm->count)++;
+        return;
+    }
+
+    CMAP_COUNT(cm, probes);
+    CMAP_COUNT(cm, hits);
+    void *blob = *link;
+    clean_values(cm, blob);
+    size_t *header = get_multi_header(cm, blob);
+    if((size_t)n > header[1]) {
+        blob = realloc(blob, blob_size(cm, key, n));
+        assert(blob != NULL);
+        *link = blob;
+        header = get_multi_header(cm, blob);
+        header[1] = n;
+    }
+    if(n > 0) memcpy(get_value(cm, blob), values, n * cm->valsz);
+    header[0] = n;
+}
+
+/* Function: cmap_get_all
+ * ----------------------
+ * Purpose: Finds the run of values stored for a key in a multimap
+ * Parameters: pointer to CMap, key of interest, where to store value count
+ * Return values: pointer to first value, or NULL if key not found
+ */
+void *cmap_get_all(const CMap *cm, const char *key, int *count) {
+    assert(cm->multi);
+    void *value = cmap_get(cm, key);
+    // count is the first of the two size_t fields in front of the values
+    *count = (value == NULL) ? 0 : ((size_t *)value)[-2];
+    return value;
+}
+
+/* Function: cmap_stats
+ * --------------------
+ * Purpose: Walks every bucket to summarize chain lengths and memory use.
+ * Parameters: pointer to CMap, pointer to stats struct to fill in
+ * Return values: void
+ */
+void cmap_stats(const CMap *cm, CMapStats *out) {
+    memset(out, 0, sizeof(*out));
+    out->count = cm->count;
+    out->nbuckets = cm->nbuckets;
+    out->load_factor = (double)cm->count / cm->nbuckets;
+    out->bucket_bytes = cm->nbuckets * sizeof(void *);
+
+    for(int i = 0; i < cm->nbuckets; i++) {
+        size_t chain = 0;
+        for(void *blob = cm->buckets[i]; blob != NULL; blob = get_next(blob)) {
+            size_t nvalues = cm->multi ? get_multi_header(cm, blob)[1] : 1;
+            out->blob_bytes += blob_size(cm, get_key(cm, blob), nvalues);
+            chain++;
+        }
+        if(chain > 0) out->used_buckets++;
+        if(chain > out->max_chain) out->max_chain = chain;
+        // last slot of histogram collects all the long chains
+        out->chain_hist[chain < CMAP_STATS_HIST ? chain : CMAP_STATS_HIST - 1]++;
+    }
+
+#ifdef CMAP_STATS
+    out->lookups = cm->ops.lookups;
+    out->hits = cm->ops.hits;
+    out->misses = cm->ops.misses;
+    out->probes = cm->ops.probes;
+#endif
+}
+
+/* Function: cmap_stats_reset
+ * --------------------------
+ * Purpose: Zeroes the compiled-in operation counters.
+ * Parameters: pointer to CMap
+ * Return values: void
+ */
+void cmap_stats_reset(CMap *cm) {
+#ifdef CMAP_STATS
+    memset(&cm->ops, 0, sizeof(cm->ops));
+#endif
+}
+
 /* Function: cmap_first
  * --------------------
  * Purpose: Gets first non-NULL key in map. Jumps buckets if needed.
@@ -268,7 +781,7 @@ void *cmap_get(const CMap *cm, const char *key) {
 const char *cmap_first(const CMap *cm) { 
     for(int i = 0; i < cm->nbuckets; i++) {
         void *bucket = cm->buckets[i];
-        if(bucket != NULL) return get_key(bucket);
+        if(bucket != NULL) return get_key(cm, bucket);
     }
     // nothing found
     return NULL;
@@ -281,20 +794,26 @@ const char *cmap_first(const CMap *cm) {
  * Return values: next valid key
  */
 const char *cmap_next(const CMap *cm, const char *prevkey) { 
+    int start_bucket = hash(cm, prevkey);
+
+    // find blob of prevkey, interned keys live in the pool rather than the blob
+    void *blob = (char *)prevkey - cm->hdrsz;
+    if(cm->pool != NULL) {
+        blob = cm->buckets[start_bucket];
+        while(get_key(cm, blob) != prevkey) blob = get_next(blob);
+    }
+
     // if there's another blob in the bucket
-    void *blob = (char *)prevkey - sizeof(void *);
     if(get_next(blob) != NULL) { 
-        return get_key(get_next(blob));
+        return get_key(cm, get_next(blob));
     }
 
-    int start_bucket = hash(prevkey, cm->nbuckets);
-
     // to jump buckets
     for(int i = start_bucket + 1; i < cm->nbuckets; i++) {
         if(cm->buckets[i] == NULL) { 
             continue;
         }
-        return get_key(cm->buckets[i]);
+        return get_key(cm, cm->buckets[i]);
     }
     
     return NULL; 
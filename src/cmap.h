@@ -15,6 +15,7 @@
 #define _cmap_h
 
 #include <stddef.h>
+#include "cstrpool.h"
 
 
  /**
@@ -33,6 +34,25 @@
 typedef void (*CleanupValueFn)(void *addr);
 
 
+/**
+ * Type: CMapHashKind
+ * ------------------
+ * Selects the function a CMap uses to hash its keys (see cmap_set_hash).
+ *
+ *   CMAP_HASH_FAST     a cheap multiplicative string hash, seeded per map.
+ *                      Bucket placement differs from map to map and run
+ *                      to run, but collisions can still be searched for.
+ *   CMAP_HASH_SIPHASH  SipHash-2-4 keyed with a secret 128-bit per-map key.
+ *                      Somewhat slower, but keys that collide cannot be
+ *                      crafted without the key, so use it for any table
+ *                      whose keys come from untrusted input.
+ */
+typedef enum {
+    CMAP_HASH_FAST,
+    CMAP_HASH_SIPHASH
+} CMapHashKind;
+
+
 /**
  * Type: CMap
  * ----------
@@ -49,6 +69,44 @@ typedef void (*CleanupValueFn)(void *addr);
 typedef struct CMapImplementation CMap;
 
 
+/**
+ * Type: CMapStats
+ * ---------------
+ * CMapStats is a snapshot of the shape of a CMap's hash table, filled in
+ * by cmap_stats. It is intended for diagnosing slow lookups: a capacity
+ * hint that is too small shows up as a high load factor, a hash that
+ * clusters shows up as a long max_chain with many empty buckets.
+ *
+ * chain_hist[i] counts the buckets whose chain holds exactly i entries,
+ * except for the last slot which counts every bucket with a chain of
+ * CMAP_STATS_HIST-1 or more entries. bucket_bytes is the size of the
+ * bucket array, blob_bytes the total size of all entry allocations.
+ *
+ * The lookups/hits/misses/probes counters are only maintained when cmap.c
+ * is compiled with CMAP_STATS defined (they stay zero otherwise, so the
+ * hot paths pay nothing by default). Every key search done by cmap_put or
+ * cmap_get is one lookup, which ends as either a hit or a miss, and each
+ * entry compared against the key along the way is one probe. Dividing
+ * probes by lookups gives the average chain walk per operation.
+ */
+#define CMAP_STATS_HIST 16
+
+typedef struct {
+    int count;
+    size_t nbuckets;
+    size_t used_buckets;
+    size_t max_chain;
+    double load_factor;
+    size_t chain_hist[CMAP_STATS_HIST];
+    size_t bucket_bytes;
+    size_t blob_bytes;
+    unsigned long lookups;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long probes;
+} CMapStats;
+
+
 /**
  * Function: cmap_create
  * Usage: CMap *m = cmap_create(sizeof(int), 10, NULL)
@@ -93,6 +151,98 @@ typedef struct CMapImplementation CMap;
 CMap *cmap_create(size_t valuesz, size_t capacity_hint, CleanupValueFn fn);
 
 
+/**
+ * Function: cmap_create_lru
+ * Usage: CMap *cache = cmap_create_lru(sizeof(double), 10000, NULL)
+ * -----------------------------------------------------------------
+ * Creates a new empty CMap that holds at most max_entries entries and
+ * behaves as a least-recently-used cache. The valuesz and fn parameters
+ * are as for cmap_create. Both cmap_get (on a hit) and cmap_put mark the
+ * entry as most recently used. When cmap_put adds a new key to a full
+ * CMap, the least recently used entry is evicted first: the client's
+ * cleanup function is called on its value and its key is discarded, so
+ * any pointer previously returned by cmap_get for that key becomes
+ * invalid. Because cmap_get updates recency, it must not be called
+ * concurrently with other operations on an LRU CMap, and cmap_get calls
+ * made while iterating do not disturb the iteration. cmap_put and cmap_get
+ * remain constant-time; the recency list is threaded through the entries
+ * themselves, at a cost of two pointers per entry. An assert is raised
+ * if max_entries is 0 or greater than INT_MAX, the most entries that
+ * cmap_count can report.
+ *
+ * Asserts: zero valuesz, zero or too large max_entries, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CMap *cmap_create_lru(size_t valuesz, size_t max_entries, CleanupValueFn fn);
+
+
+/**
+ * Function: cmap_create_multi
+ * Usage: CMap *m = cmap_create_multi(sizeof(char *), 35000, NULL)
+ * ---------------------------------------------------------------
+ * Creates a new empty CMap in which each key is associated with a list
+ * of values rather than a single one (a "multimap"). The parameters are
+ * as for cmap_create. Values are added with cmap_append or cmap_put_all
+ * and read back with cmap_get_all. A key's values are stored
+ * contiguously, in the same allocation as the key itself, so a
+ * one-to-many mapping costs one allocation per key and one pointer hop
+ * per lookup (compared to storing a CVector * per key). cmap_get returns
+ * the first value of the key and cmap_put replaces all of a key's values
+ * with a single new one (the cleanup function is called on each old
+ * value). cmap_count counts keys, not values. The cleanup function is
+ * called on every value when the CMap is disposed.
+ *
+ * Asserts: zero valuesz, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CMap *cmap_create_multi(size_t valuesz, size_t capacity_hint, CleanupValueFn fn);
+
+
+/**
+ * Function: cmap_set_hash
+ * Usage: cmap_set_hash(m, CMAP_HASH_SIPHASH, NULL)
+ * ------------------------------------------------
+ * Chooses the hash function for the CMap. A new CMap uses CMAP_HASH_FAST
+ * with a random seed, so this call is only needed to opt into SipHash or
+ * to fix the seed. seed points to 16 bytes of key material; if seed is
+ * NULL, a fresh random seed is drawn from the system. A fixed seed makes
+ * bucket placement and iteration order reproducible, which is handy for
+ * testing but gives up the protection against crafted collisions. A CMap
+ * that interns its keys (see cmap_intern_keys) hashes the address of the
+ * pooled key rather than its characters, so for it kind is ignored and
+ * only the seed is used. The CMap must be empty since existing entries
+ * would be in the wrong buckets. Operates in constant-time.
+ *
+ * Asserts: CMap not empty, invalid kind
+ */
+void cmap_set_hash(CMap *cm, CMapHashKind kind, const void *seed);
+
+
+/**
+ * Function: cmap_intern_keys
+ * Usage: cmap_intern_keys(m, pool)
+ * --------------------------------
+ * Makes the CMap intern its keys in the given CStrPool instead of copying
+ * them. Each entry then stores only a pointer to the pool's canonical
+ * copy of its key, so a string that is a key in several maps (or also
+ * stored elsewhere through the same pool) is kept in memory once, and
+ * keys are compared by pointer instead of strcmp. cmap_put and cmap_append
+ * intern the key they are given; cmap_get only looks the key up in the
+ * pool, so querying missing keys does not grow the pool. The keys returned
+ * by cmap_first/cmap_next are the canonical pool strings and remain valid
+ * until the pool is disposed. The CMap does not take ownership of the pool,
+ * which must outlive the CMap. Since each key string is unique in the
+ * pool, the CMap hashes the key's address instead of its characters, and
+ * the hash kind chosen by cmap_set_hash has no effect (the seed still
+ * applies). A CStrPool never releases strings, so an LRU CMap, whose
+ * evicted keys would stay in the pool forever, cannot intern its keys.
+ * The CMap must be empty. Operates in constant-time.
+ *
+ * Asserts: CMap not empty, NULL pool, LRU CMap
+ */
+void cmap_intern_keys(CMap *cm, CStrPool *pool);
+
+
 /**
  * Function: cmap_dispose
  * Usage: cmap_dispose(m)
@@ -154,6 +304,89 @@ void cmap_put(CMap *cm, const char *key, const void *addr);
 void *cmap_get(const CMap *cm, const char *key);
 
 
+/**
+ * Function: cmap_append
+ * Usage: cmap_append(m, "cold", &synonym)
+ * ---------------------------------------
+ * Adds a value to the end of the list of values associated with key in
+ * a CMap created by cmap_create_multi. If the key is not yet in the CMap,
+ * it is added with addr as its only value. The value at addr is copied
+ * into internal CMap storage. Appending may move the key's values, so
+ * pointers previously returned by cmap_get/cmap_get_all for this key
+ * (and the key string returned by cmap_first/cmap_next) become invalid.
+ * An assert is raised if the CMap is not a multimap, or on allocation
+ * failure. Operates in constant-time (amortized).
+ *
+ * Asserts: not a multimap, allocation failure
+ * Assumes: key is valid, address of valid value
+ */
+void cmap_append(CMap *cm, const char *key, const void *addr);
+
+
+/**
+ * Function: cmap_put_all
+ * Usage: cmap_put_all(m, "cold", synonyms, nsynonyms)
+ * ---------------------------------------------------
+ * Associates key with a new list of n values in a CMap created by
+ * cmap_create_multi, replacing any values it had (the cleanup function
+ * is called on each old value). values points to n values stored back to
+ * back; they are copied into internal CMap storage. n may be 0, in which
+ * case the key is present with no values: cmap_get_all finds it with a
+ * count of 0, and cmap_get returns a pointer that must not be
+ * dereferenced. Like cmap_append, this may move the key's values. An
+ * assert is raised if the CMap is not a multimap, n is negative, or on
+ * allocation failure. Operates in constant-time plus the time to copy
+ * the values.
+ *
+ * Asserts: not a multimap, negative n, allocation failure
+ * Assumes: key is valid, values holds n valid values
+ */
+void cmap_put_all(CMap *cm, const char *key, const void *values, int n);
+
+
+/**
+ * Function: cmap_get_all
+ * Usage: int n; char **syns = cmap_get_all(m, "cold", &n)
+ * -------------------------------------------------------
+ * Searches a multimap for key and if found, returns a pointer to the
+ * first of its values and stores the number of values in *count. The
+ * values are contiguous, so the ith value is at (char *)result + i*valuesz
+ * (or simply result[i] through a typed pointer). If the key is not found,
+ * NULL is returned and *count is set to 0. The pointer is subject to the
+ * same invalidation rules as cmap_get, and additionally is invalidated by
+ * a cmap_append to the same key. Operates in constant-time.
+ *
+ * Asserts: not a multimap
+ * Assumes: key is valid, count is valid
+ */
+void *cmap_get_all(const CMap *cm, const char *key, int *count);
+
+
+/**
+ * Function: cmap_stats
+ * Usage: CMapStats st; cmap_stats(m, &st)
+ * ---------------------------------------
+ * Fills in out with a snapshot of the CMap's bucket occupancy, chain
+ * lengths, load factor and memory use, plus the operation counters if
+ * they were compiled in (see CMapStats). Walks every chain, so it
+ * operates in linear-time and is meant for diagnostics, not hot paths.
+ *
+ * Assumes: out is valid
+ */
+void cmap_stats(const CMap *cm, CMapStats *out);
+
+
+/**
+ * Function: cmap_stats_reset
+ * Usage: cmap_stats_reset(m)
+ * --------------------------
+ * Zeroes the lookups/hits/misses/probes counters so a measurement can be
+ * taken over a single phase of a program. Has no effect unless cmap.c
+ * is compiled with CMAP_STATS. Operates in constant-time.
+ */
+void cmap_stats_reset(CMap *cm);
+
+
 /**
  * Functions: cmap_first, cmap_next
  * Usage: for (const char *key = cmap_first(m); key != NULL; key = cmap_next(m, key))
@@ -0,0 +1,166 @@
+/*
+ * File: csegvec.c
+ * ---------------
+ * Implementation of segmented arrays with stable element addresses in C.
+ * Uses a directory of fixed-size chunks, published with C11 atomics so
+ * readers need no lock while a single writer appends.
+ */
+
+#include "csegvec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+
+// elements per chunk when given chunk_hint is 0
+#define DEFAULT_CHUNK 1024
+
+// chunk slots in the first directory, doubled as it fills
+#define DEFAULT_DIR 16
+
+/* Type: struct CSegVectorImplementation
+ * -------------------------------------
+ * This definition completes the CSegVector type that was declared in
+ * csegvec.h. The directory is an array of pointers whose slot 0 links to
+ * the directory it replaced and whose slots 1.. point to the chunks. A
+ * directory that is outgrown is not freed, since a reader may still be
+ * looking through it; old directories are freed at dispose. Their total
+ * size is less than the current one, so this at most doubles the small
+ * directory overhead.
+ */
+typedef struct CSegVectorImplementation {
+    _Atomic size_t size; // elements published to readers
+    void **_Atomic dir; // current directory
+    size_t dircap; // chunk slots in current directory
+    size_t nchunks; // chunks allocated
+    size_t shift; // log2 of elements per chunk
+    size_t elemsz;
+    CleanupElemFn clean;
+} CSegVector;
+
+
+/* Function: get_nth
+ * -----------------
+ * Purpose: Locates an element through a directory.
+ * Parameters: pointer to CSegVector, directory, index
+ * Return values: pointer to element
+ */
+static void *get_nth(const CSegVector *sv, void **dir, size_t n) {
+    size_t mask = ((size_t)1 << sv->shift) - 1;
+    return (char *)dir[1 + (n >> sv->shift)] + (n & mask) * sv->elemsz;
+}
+
+/* Function: csegvec_create
+ * ------------------------
+ * Purpose: Allocates an empty segmented vector and its first directory.
+ * Parameters: element size, chunk size hint, cleanup callback function
+ * Return values: pointer to CSegVector
+ */
+CSegVector *csegvec_create(size_t elemsz, size_t chunk_hint, CleanupElemFn fn) {
+    assert(elemsz != 0);
+    CSegVector *sv = malloc(sizeof(CSegVector));
+    assert(sv != NULL);
+
+    if(chunk_hint == 0) chunk_hint = DEFAULT_CHUNK;
+    sv->shift = 0;
+    while(((size_t)1 << sv->shift) < chunk_hint) sv->shift++;
+
+    void **dir = calloc(1 + DEFAULT_DIR, sizeof(void *));
+    assert(dir != NULL);
+    atomic_init(&sv->dir, dir);
+    atomic_init(&sv->size, 0);
+    sv->dircap = DEFAULT_DIR;
+    sv->nchunks = 0;
+    sv->elemsz = elemsz;
+    sv->clean = fn;
+    return sv;
+}
+
+/* Function: csegvec_dispose
+ * -------------------------
+ * Purpose: Cleans elements and frees chunks and every directory.
+ * Parameters: pointer to CSegVector
+ * Return values: void
+ */
+void csegvec_dispose(CSegVector *sv) {
+    size_t size = atomic_load_explicit(&sv->size, memory_order_relaxed);
+    void **dir = atomic_load_explicit(&sv->dir, memory_order_relaxed);
+    if(sv->clean != NULL) {
+        for(size_t i = 0; i < size; i++) sv->clean(get_nth(sv, dir, i));
+    }
+    for(size_t k = 0; k < sv->nchunks; k++) free(dir[1 + k]);
+    // follow the chain of retired directories
+    while(dir != NULL) {
+        void **prev = dir[0];
+        free(dir);
+        dir = prev;
+    }
+    free(sv);
+}
+
+/* Function: csegvec_count
+ * -----------------------
+ * Purpose: Gets number of published elements
+ * Parameters: pointer to CSegVector
+ * Return values: int count
+ */
+int csegvec_count(const CSegVector *sv) {
+    // acquire pairs with the release in append: elements below count are written
+    return atomic_load_explicit(&((CSegVector *)sv)->size, memory_order_acquire);
+}
+
+/* Function: csegvec_nth
+ * ---------------------
+ * Purpose: Finds the chunk holding an index and the offset within it
+ * Parameters: pointer to CSegVector, index
+ * Return values: pointer to element
+ */
+void *csegvec_nth(const CSegVector *sv, int index) {
+    CSegVector *s = (CSegVector *)sv; // atomics are loaded, never stored, here
+    size_t size = atomic_load_explicit(&s->size, memory_order_acquire);
+    // index out of bounds check
+    assert(index >= 0 && (size_t)index < size);
+    // any directory published after size was read still holds every older chunk
+    return get_nth(sv, atomic_load_explicit(&s->dir, memory_order_acquire), index);
+}
+
+/* Function: add_chunk
+ * -------------------
+ * Purpose: Allocates one more chunk, first publishing a directory twice as
+ * large if the current one is full. Writer only.
+ * Parameters: pointer to CSegVector
+ * Return values: void
+ */
+static void add_chunk(CSegVector *sv) {
+    void **dir = atomic_load_explicit(&sv->dir, memory_order_relaxed);
+    if(sv->nchunks == sv->dircap) {
+        void **bigger = calloc(1 + 2 * sv->dircap, sizeof(void *));
+        assert(bigger != NULL);
+        memcpy(bigger + 1, dir + 1, sv->nchunks * sizeof(void *));
+        bigger[0] = dir; // retire, do not free
+        sv->dircap *= 2;
+        atomic_store_explicit(&sv->dir, bigger, memory_order_release);
+        dir = bigger;
+    }
+    void *chunk = malloc(sv->elemsz << sv->shift);
+    assert(chunk != NULL);
+    dir[1 + sv->nchunks] = chunk;
+    sv->nchunks++;
+}
+
+/* Function: csegvec_append
+ * ------------------------
+ * Purpose: Copies an element into the next free slot, then publishes it.
+ * Parameters: pointer to CSegVector, address of element to append
+ * Return values: pointer to stored element
+ */
+void *csegvec_append(CSegVector *sv, const void *addr) {
+    size_t size = atomic_load_explicit(&sv->size, memory_order_relaxed);
+    if((size >> sv->shift) == sv->nchunks) add_chunk(sv);
+
+    void *slot = get_nth(sv, atomic_load_explicit(&sv->dir, memory_order_relaxed), size);
+    memcpy(slot, addr, sv->elemsz);
+    // release: a reader that sees the new size also sees the element and its chunk
+    atomic_store_explicit(&sv->size, size + 1, memory_order_release);
+    return slot;
+}
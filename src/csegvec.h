@@ -0,0 +1,111 @@
+/* File: csegvec.h
+ * ---------------
+ * Defines the interface for the CSegVector type.
+ *
+ * The CSegVector is an indexed, append-only collection of homogeneous
+ * elements, like a CVector, but with one important difference: elements
+ * never move. A CVector keeps its elements in one contiguous block and
+ * reallocates it as it grows, so every pointer into it is invalidated by
+ * the next append. A CSegVector instead stores its elements in a list of
+ * fixed-size chunks, found through a directory. Appending fills the last
+ * chunk or adds a new one, and never relocates existing elements, so a
+ * pointer to an element stays valid until the CSegVector is disposed.
+ * Indexing is still constant-time: one shift and mask to find the chunk
+ * and the offset within it.
+ *
+ * Because elements do not move, a CSegVector can be read by several
+ * threads while one thread appends to it, without locking: readers may
+ * call csegvec_count and csegvec_nth concurrently with csegvec_append and
+ * will always see fully written elements. Only one thread may append at a
+ * time, and disposal must wait until all readers are done.
+ */
+
+#ifndef _csegvec_h
+#define _csegvec_h
+
+#include "cvector.h" // CleanupElemFn
+#include <stddef.h>
+
+
+/**
+ * Type: CSegVector
+ * ----------------
+ * Defines the CSegVector type. As with the CVector, the type is
+ * incomplete; clients declare only CSegVector * pointers and manipulate
+ * the vector solely through the functions listed in this interface.
+ */
+typedef struct CSegVectorImplementation CSegVector;
+
+
+/**
+ * Function: csegvec_create
+ * Usage: CSegVector *sv = csegvec_create(sizeof(Record), 4096, NULL)
+ * ------------------------------------------------------------------
+ * Creates a new empty CSegVector and returns a pointer to it. The elemsz
+ * and fn parameters are as for cvec_create. The chunk_hint parameter is
+ * the number of elements stored in each chunk; it is rounded up to a power
+ * of two, and if it is 0, an internal default is used. Larger chunks mean
+ * fewer allocations but more unused space in the last chunk. When done,
+ * the client must call csegvec_dispose.
+ *
+ * Asserts: zero elemsz, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CSegVector *csegvec_create(size_t elemsz, size_t chunk_hint, CleanupElemFn fn);
+
+
+/**
+ * Function: csegvec_dispose
+ * Usage: csegvec_dispose(sv)
+ * --------------------------
+ * Disposes of the CSegVector. Calls the client's cleanup function on each
+ * element and deallocates all storage. No other thread may be using the
+ * CSegVector. Operates in linear-time.
+ */
+void csegvec_dispose(CSegVector *sv);
+
+
+/**
+ * Function: csegvec_count
+ * Usage: int count = csegvec_count(sv)
+ * ------------------------------------
+ * Returns the number of elements currently stored in the CSegVector. May
+ * be called concurrently with csegvec_append; every index below the
+ * returned count is safe to pass to csegvec_nth. Operates in constant-time.
+ */
+int csegvec_count(const CSegVector *sv);
+
+
+/**
+ * Function: csegvec_nth
+ * Usage: Record *r = csegvec_nth(sv, 0)
+ * -------------------------------------
+ * Accesses the element at a given index and returns a pointer to the
+ * memory location where it is stored. Valid indexes are 0 to count-1; an
+ * assert is raised if index is out of bounds. Unlike cvec_nth, the pointer
+ * remains valid across later appends, for as long as the CSegVector
+ * exists. May be called concurrently with csegvec_append.
+ * Operates in constant-time.
+ *
+ * Asserts: invalid index
+ */
+void *csegvec_nth(const CSegVector *sv, int index);
+
+
+/**
+ * Function: csegvec_append
+ * Usage: Record *stored = csegvec_append(sv, &rec)
+ * ------------------------------------------------
+ * Appends a new element to the end of the CSegVector, copying the value
+ * from the memory location pointed to by addr, and returns a pointer to
+ * the stored copy. The element becomes visible to concurrent readers
+ * (through csegvec_count) only once it is completely written. Only one
+ * thread may append at a time. An assert is raised on allocation failure.
+ * Operates in constant-time (amortized).
+ *
+ * Asserts: allocation failure
+ * Assumes: address of valid elem
+ */
+void *csegvec_append(CSegVector *sv, const void *addr);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * File: cstrpool.c
+ * ----------------
+ * Implementation of a string interning pool in C.
+ * Uses an open-addressing hash set over strings packed into an arena.
+ */
+
+#include "cstrpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <sys/random.h>
+
+// a suggested value to use when given capacity_hint is 0
+#define DEFAULT_CAPACITY 1024
+
+// bytes of string data in each arena block, larger strings get their own
+#define BLOCK_SIZE 65536
+
+/* Type: struct Slot
+ * -----------------
+ * One entry of the hash set. The full hash is kept next to the string
+ * pointer so that probing and rehashing rarely have to touch the string.
+ */
+typedef struct {
+    const char *str; // canonical string, NULL if slot is empty
+    uint64_t hash;
+} Slot;
+
+/* Type: struct CStrPoolImplementation
+ * -----------------------------------
+ * This definition completes the CStrPool type that was declared in
+ * cstrpool.h. Arena blocks form a linked list through their first word,
+ * newest first; strings are bump-allocated from the newest block.
+ */
+typedef struct CStrPoolImplementation {
+    Slot *slots;
+    size_t nslots; // always a power of two
+    int count;
+    void *blocks; // newest arena block
+    char *free_ptr; // next free byte in newest block
+    size_t free_left; // bytes left in newest block
+    uint64_t seed; // randomizes probe sequences per pool
+} CStrPool;
+
+
+/* Function: hash_str
+ * ------------------
+ * Purpose: Computes a seeded 64-bit FNV-1a style hash of a string.
+ * Parameters: string, seed
+ * Return values: hash code
+ */
+static uint64_t hash_str(const char *s, uint64_t seed) {
+    uint64_t hashcode = seed ^ 0xcbf29ce484222325ULL;
+    for(int i = 0; s[i] != '\0'; i++)
+        hashcode = (hashcode ^ (unsigned char)s[i]) * 0x100000001b3ULL;
+    hashcode ^= hashcode >> 32; // fold high bits in, slots are picked by low bits
+    return hashcode;
+}
+
+/* Function: find_slot
+ * -------------------
+ * Purpose: Linear probe for a string, stopping at a match or an empty slot.
+ * Parameters: pointer to CStrPool, string, its hash
+ * Return values: pointer to matching or empty slot
+ */
+static Slot *find_slot(const CStrPool *sp, const char *s, uint64_t hash) {
+    size_t mask = sp->nslots - 1;
+    for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Slot *slot = &sp->slots[i];
+        if(slot->str == NULL) return slot;
+        if(slot->hash == hash && strcmp(slot->str, s) == 0) return slot;
+    }
+}
+
+/* Function: grow_slots
+ * --------------------
+ * Purpose: Doubles the hash set and reinserts every string. Strings stay
+ * where they are in the arena, only the slot array is rebuilt.
+ * Parameters: pointer to CStrPool
+ * Return values: void
+ */
+static void grow_slots(CStrPool *sp) {
+    Slot *old = sp->slots;
+    size_t oldn = sp->nslots;
+    sp->nslots *= 2;
+    sp->slots = calloc(sp->nslots, sizeof(Slot));
+    assert(sp->slots != NULL);
+
+    size_t mask = sp->nslots - 1;
+    for(size_t i = 0; i < oldn; i++) {
+        if(old[i].str == NULL) continue;
+        size_t j = old[i].hash & mask;
+        while(sp->slots[j].str != NULL) j = (j + 1) & mask;
+        sp->slots[j] = old[i];
+    }
+    free(old);
+}
+
+/* Function: arena_copy
+ * --------------------
+ * Purpose: Copies a string into the arena, starting a new block if the
+ * current one is full.
+ * Parameters: pointer to CStrPool, string, its length
+ * Return values: pointer to the copy
+ */
+static char *arena_copy(CStrPool *sp, const char *s, size_t len) {
+    if(len + 1 > sp->free_left) {
+        size_t datasz = (len + 1 > BLOCK_SIZE / 4) ? len + 1 : BLOCK_SIZE;
+        void *block = malloc(sizeof(void *) + datasz);
+        assert(block != NULL);
+        if(datasz == BLOCK_SIZE) {
+            // new current block
+            *(void **)block = sp->blocks;
+            sp->blocks = block;
+            sp->free_ptr = (char *)block + sizeof(void *);
+            sp->free_left = datasz;
+        } else {
+            // oversized string, keep it behind the current block so its leftover space is not lost
+            if(sp->blocks == NULL) {
+                *(void **)block = NULL;
+                sp->blocks = block;
+            } else {
+                *(void **)block = *(void **)sp->blocks;
+                *(void **)sp->blocks = block;
+            }
+            return memcpy((char *)block + sizeof(void *), s, len + 1);
+        }
+    }
+    char *copy = memcpy(sp->free_ptr, s, len + 1);
+    sp->free_ptr += len + 1;
+    sp->free_left -= len + 1;
+    return copy;
+}
+
+/* Function: cstrpool_create
+ * -------------------------
+ * Purpose: Allocates an empty pool sized for the hinted number of strings.
+ * Parameters: capacity hint
+ * Return values: pointer to CStrPool
+ */
+CStrPool *cstrpool_create(size_t capacity_hint) {
+    CStrPool *sp = malloc(sizeof(CStrPool));
+    assert(sp != NULL);
+
+    if(capacity_hint == 0) capacity_hint = DEFAULT_CAPACITY;
+    // keep load at most 3/4, slot count a power of two for masking
+    sp->nslots = 16;
+    while(sp->nslots * 3 / 4 < capacity_hint) sp->nslots *= 2;
+    sp->slots = calloc(sp->nslots, sizeof(Slot));
+    assert(sp->slots != NULL);
+
+    sp->count = 0;
+    sp->blocks = NULL;
+    sp->free_ptr = NULL;
+    sp->free_left = 0;
+    if(getrandom(&sp->seed, sizeof(sp->seed), 0) != sizeof(sp->seed))
+        sp->seed = (uintptr_t)sp;
+    return sp;
+}
+
+/* Function: cstrpool_dispose
+ * --------------------------
+ * Purpose: Frees the hash set, every arena block and the pool.
+ * Parameters: pointer to CStrPool
+ * Return values: void
+ */
+void cstrpool_dispose(CStrPool *sp) {
+    while(sp->blocks != NULL) {
+        void *block = sp->blocks;
+        sp->blocks = *(void **)block;
+        free(block);
+    }
+    free(sp->slots);
+    free(sp);
+}
+
+/* Function: cstrpool_count
+ * ------------------------
+ * Purpose: Gets number of distinct strings in pool
+ * Parameters: pointer to CStrPool
+ * Return values: int count
+ */
+int cstrpool_count(const CStrPool *sp) {
+    return sp->count;
+}
+
+/* Function: cstrpool_intern
+ * -------------------------
+ * Purpose: Finds or adds the canonical copy of a string.
+ * Parameters: pointer to CStrPool, string
+ * Return values: canonical string
+ */
+const char *cstrpool_intern(CStrPool *sp, const char *s) {
+    uint64_t hash = hash_str(s, sp->seed);
+    Slot *slot = find_slot(sp, s, hash);
+    if(slot->str != NULL) return slot->str;
+
+    if((sp->count + 1) * 4 > sp->nslots * 3) {
+        grow_slots(sp);
+        slot = find_slot(sp, s, hash);
+    }
+    slot->str = arena_copy(sp, s, strlen(s));
+    slot->hash = hash;
+    (sp->count)++;
+    return slot->str;
+}
+
+/* Function: cstrpool_lookup
+ * -------------------------
+ * Purpose: Finds the canonical copy of a string without adding it.
+ * Parameters: pointer to CStrPool, string
+ * Return values: canonical string or NULL if not interned
+ */
+const char *cstrpool_lookup(const CStrPool *sp, const char *s) {
+    return find_slot(sp, s, hash_str(s, sp->seed))->str;
+}
@@ -0,0 +1,99 @@
+/* File: cstrpool.h
+ * ----------------
+ * Defines the interface for the CStrPool type.
+ *
+ * The CStrPool is a string interner. Interning a string returns a
+ * canonical copy of it owned by the pool: every call with equal strings
+ * returns the very same pointer. Data sets in which the same words recur
+ * many times (as keys of a CMap and elements of many CVectors, say) can
+ * store each distinct string once, and code holding interned strings can
+ * test equality by comparing pointers instead of calling strcmp.
+ * Canonical strings are packed into large arena blocks, so interning
+ * costs no per-string heap allocation, and they are never moved or freed
+ * until the whole pool is disposed.
+ */
+
+#ifndef _cstrpool_h
+#define _cstrpool_h
+
+#include <stddef.h>
+
+
+/**
+ * Type: CStrPool
+ * --------------
+ * Defines the CStrPool type. Like CVector and CMap, the type is
+ * incomplete; clients declare only CStrPool * pointers and manipulate
+ * the pool solely through the functions listed in this interface.
+ */
+typedef struct CStrPoolImplementation CStrPool;
+
+
+/**
+ * Function: cstrpool_create
+ * Usage: CStrPool *pool = cstrpool_create(50000)
+ * ----------------------------------------------
+ * Creates a new empty CStrPool and returns a pointer to it. When done with
+ * the pool, the client must call cstrpool_dispose, after which every
+ * string returned from the pool is invalid. The capacity_hint parameter
+ * is an estimate of the number of distinct strings that will be interned;
+ * the pool grows as needed, so this is not a binding limit. If
+ * capacity_hint is 0, an internal default value is used.
+ *
+ * Asserts: allocation failure
+ */
+CStrPool *cstrpool_create(size_t capacity_hint);
+
+
+/**
+ * Function: cstrpool_dispose
+ * Usage: cstrpool_dispose(pool)
+ * -----------------------------
+ * Disposes of the CStrPool and all the canonical strings it holds.
+ * Any CMap using the pool for its keys must be disposed of first.
+ * Operates in linear-time.
+ */
+void cstrpool_dispose(CStrPool *sp);
+
+
+/**
+ * Function: cstrpool_count
+ * Usage: int n = cstrpool_count(pool)
+ * -----------------------------------
+ * Returns the number of distinct strings interned in the CStrPool.
+ * Operates in constant-time.
+ */
+int cstrpool_count(const CStrPool *sp);
+
+
+/**
+ * Function: cstrpool_intern
+ * Usage: const char *word = cstrpool_intern(pool, buffer)
+ * -------------------------------------------------------
+ * Returns the pool's canonical copy of the string s, first adding a copy
+ * to the pool if no equal string has been interned before. The returned
+ * pointer stays valid until the pool is disposed, and is the same pointer
+ * for every call with an equal string (compared case-sensitively). The
+ * client must not modify or free the returned string. Operates in
+ * constant-time (amortized).
+ *
+ * Asserts: allocation failure
+ * Assumes: s is valid
+ */
+const char *cstrpool_intern(CStrPool *sp, const char *s);
+
+
+/**
+ * Function: cstrpool_lookup
+ * Usage: const char *word = cstrpool_lookup(pool, buffer)
+ * -------------------------------------------------------
+ * Returns the pool's canonical copy of the string s if one has been
+ * interned, or NULL if not. Unlike cstrpool_intern, it never adds to the
+ * pool, so it is suited to looking up untrusted input without growing
+ * the pool. Operates in constant-time.
+ *
+ * Assumes: s is valid
+ */
+const char *cstrpool_lookup(const CStrPool *sp, const char *s);
+
+#endif
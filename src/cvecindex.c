@@ -0,0 +1,170 @@
+/*
+ * File: cvecindex.c
+ * -----------------
+ * Implementation of Eytzinger-layout search indexes for sorted CVectors.
+ * Node k of the implicit search tree (1-based) has children 2k and 2k+1;
+ * an in-order walk of the tree visits the elements in sorted order.
+ */
+
+#include "cvecindex.h"
+#include "cvector_inline.h" // cvec_nth_inline and elemsz
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// cache line size assumed for alignment and prefetch distance
+#define LINE 64
+
+// keys searched in step by cvec_index_search_many
+#define BATCH 32
+
+/* Type: struct CVecIndexImplementation
+ * ------------------------------------
+ * This definition completes the CVecIndex type that was declared in
+ * cvecindex.h. tree holds n+1 element slots, slot 0 unused, aligned so
+ * that a run of descendants starts on a cache line. rank[k] is the
+ * CVector index of the element in node k.
+ */
+typedef struct CVecIndexImplementation {
+    char *tree;
+    int *rank;
+    size_t n;
+    size_t elemsz;
+    CompareFn cmp;
+    size_t ahead; // descendants per cache line, a power of two
+    int levels; // depth of the complete part of the tree
+} CVecIndex;
+
+
+/* Function: node
+ * --------------
+ * Purpose: Performs pointer arithmetic on tree nodes.
+ * Parameters: pointer to CVecIndex, node number
+ * Return values: pointer to node's element
+ */
+static const char *node(const CVecIndex *ix, size_t k) {
+    return ix->tree + k*ix->elemsz;
+}
+
+/* Function: fill
+ * --------------
+ * Purpose: Walks the subtree under node k in order, copying the next
+ * sorted elements into its nodes.
+ * Parameters: pointer to CVecIndex, source CVector, next source index,
+ * node number
+ * Return values: next source index after the subtree
+ */
+static size_t fill(CVecIndex *ix, const CVector *cv, size_t i, size_t k) {
+    if(k > ix->n) return i;
+    i = fill(ix, cv, i, 2*k);
+    memcpy(ix->tree + k*ix->elemsz, cvec_nth_inline(cv, i), ix->elemsz);
+    ix->rank[k] = i;
+    return fill(ix, cv, i + 1, 2*k + 1);
+}
+
+/* Function: cvec_index_create
+ * ---------------------------
+ * Purpose: Copies a sorted CVector into Eytzinger order
+ * Parameters: pointer to sorted CVector, compare callback function
+ * Return values: pointer to CVecIndex
+ */
+CVecIndex *cvec_index_create(const CVector *cv, CompareFn cmp) {
+    CVecIndex *ix = malloc(sizeof(CVecIndex));
+    assert(ix != NULL);
+    ix->n = cvec_count_inline(cv);
+    ix->elemsz = cv->elemsz;
+    ix->cmp = cmp;
+
+    size_t nbytes = (ix->n + 1) * ix->elemsz;
+    void *tree;
+    ix->tree = (posix_memalign(&tree, LINE, nbytes) == 0) ? tree : NULL;
+    ix->rank = malloc((ix->n + 1) * sizeof(int));
+    assert(ix->tree != NULL && ix->rank != NULL);
+    fill(ix, cv, 0, 1);
+
+    // prefetch as many levels ahead as one cache line of descendants covers
+    ix->ahead = 2;
+    while(ix->ahead * 2 * ix->elemsz <= LINE) ix->ahead *= 2;
+    ix->levels = 0;
+    while(((size_t)2 << ix->levels) - 1 <= ix->n) ix->levels++;
+    return ix;
+}
+
+/* Function: cvec_index_dispose
+ * ----------------------------
+ * Purpose: Frees the tree copy and ranks
+ * Parameters: pointer to CVecIndex
+ * Return values: void
+ */
+void cvec_index_dispose(CVecIndex *ix) {
+    free(ix->tree);
+    free(ix->rank);
+    free(ix);
+}
+
+/* Function: step
+ * --------------
+ * Purpose: Moves one level down from node k, to the left child if the
+ * node's element does not sort before the key, else to the right, and
+ * prefetches the line of descendants several levels below.
+ * Parameters: pointer to CVecIndex, node number, address of key
+ * Return values: child node number
+ */
+static inline size_t step(const CVecIndex *ix, size_t k, const void *key) {
+    // may point past the tree near the bottom; a prefetch never faults
+    __builtin_prefetch(ix->tree + k*ix->ahead*ix->elemsz);
+    return 2*k + (ix->cmp(key, node(ix, k)) > 0);
+}
+
+/* Function: finish
+ * ----------------
+ * Purpose: Recovers the lower bound from the node number a search fell
+ * off the tree at: the last node where it went left, found by dropping
+ * the trailing right-turns (1 bits) and the final left-turn.
+ * Parameters: pointer to CVecIndex, node number past the bottom, address of key
+ * Return values: CVector index of matching element, or -1
+ */
+static int finish(const CVecIndex *ix, size_t k, const void *key) {
+    k >>= __builtin_ctzl(~k) + 1;
+    if(k == 0 || ix->cmp(key, node(ix, k)) != 0) return -1;
+    return ix->rank[k];
+}
+
+/* Function: cvec_index_search
+ * ---------------------------
+ * Purpose: Walks down the tree to the lower bound of the key
+ * Parameters: pointer to CVecIndex, address of key
+ * Return values: CVector index of matching element, or -1
+ */
+int cvec_index_search(const CVecIndex *ix, const void *keyaddr) {
+    size_t k = 1;
+    while(k <= ix->n) k = step(ix, k, keyaddr);
+    return finish(ix, k, keyaddr);
+}
+
+/* Function: cvec_index_search_many
+ * --------------------------------
+ * Purpose: Walks BATCH searches down the tree together. Every search
+ * takes the same number of steps through the complete levels, so the
+ * batch moves in lockstep without checks, then takes at most one more
+ * step into the partial bottom level.
+ * Parameters: pointer to CVecIndex, array of keys, number of keys,
+ * array for results
+ * Return values: void
+ */
+void cvec_index_search_many(const CVecIndex *ix, const void *keys, int nkeys, int *found) {
+    const char *key = keys;
+    size_t k[BATCH];
+    for(int first = 0; first < nkeys; first += BATCH) {
+        int m = (nkeys - first < BATCH) ? nkeys - first : BATCH;
+        const char *batch = key + first*ix->elemsz;
+        for(int g = 0; g < m; g++) k[g] = 1;
+        for(int level = 0; level < ix->levels; level++) {
+            for(int g = 0; g < m; g++) k[g] = step(ix, k[g], batch + g*ix->elemsz);
+        }
+        for(int g = 0; g < m; g++) {
+            if(k[g] <= ix->n) k[g] = step(ix, k[g], batch + g*ix->elemsz);
+            found[first + g] = finish(ix, k[g], batch + g*ix->elemsz);
+        }
+    }
+}
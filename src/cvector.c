@@ -5,30 +5,50 @@
  * Implementation of dynamically-allocated arrays in C.
  */
 
-#include "cvector.h"
+#define _GNU_SOURCE // for mremap
+#include "cvector_inline.h" // completes struct CVectorImplementation
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <assert.h>
 #include <string.h>
 #include <search.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 // a suggested value to use when given capacity_hint is 0
 #define DEFAULT_CAPACITY 16
 
-/* Type: struct CVectorImplementation
- * ----------------------------------
- * This definition completes the CVector type that was declared in
- * cvector.h. You fill in the struct with your chosen fields.
- */
-typedef struct CVectorImplementation {
-    void *data; // pointer to contiguous memory where data is in heap
-    size_t size; // number of elements in CVector
-    size_t capacity; // number of elements possible with current allocated memory
-    size_t elemsz; // number of bytes required by each element
-    CleanupElemFn clean; // cleanup function
-} CVector;
+// storage at least this large is mmap'ed and grown with mremap
+#ifndef CVEC_MMAP_THRESHOLD
+#define CVEC_MMAP_THRESHOLD (64UL << 20)
+#endif
+
+// below this many elements cvec_sort_keyed insertion sorts instead of radix passes
+#define RADIX_MIN 64
+
+// cvec_sort_keyed digit size: a 64-bit key takes 6 passes, and 2048 counters fit in L1/L2
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// cvec_nth_element insertion sorts ranges this small rather than partitioning them
+#define SELECT_INSERTION 16
+
+// a vector whose initial storage is this small gets it inside the struct's block
+#ifndef CVEC_INLINE_MAX
+#define CVEC_INLINE_MAX 256
+#endif
+
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+#define CVEC_USE_MREMAP
+#endif
 
+// x86-64 always has SSE2; AVX2 is used when the processor reports it
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CVEC_USE_SIMD
+#include <immintrin.h>
+#endif
 
 /* Function: get_nth
  * -----------------
@@ -37,7 +57,171 @@ typedef struct CVectorImplementation {
  * Return values: void * pointer to n
  */
 void *get_nth(const CVector *cv, int n) {
-    return (char *)cv->data + n*cv->elemsz;
+    // storage is a ring: element 0 is at slot head and slots wrap at capacity
+    size_t slot = cv->head + n;
+    if(slot >= cv->capacity) slot -= cv->capacity;
+    return (char *)cv->data + slot*cv->elemsz;
+}
+
+/* Function: wraps
+ * ---------------
+ * Purpose: Tells whether the elements run past the end of storage and
+ * continue at slot 0, so they are not one contiguous block.
+ * Parameters: pointer to CVector, number of elements to check room for
+ * Return values: true if slots head..head+n-1 cross the end of storage
+ */
+static bool wraps(const CVector *cv, size_t n) {
+    return cv->head + n > cv->capacity;
+}
+
+/* Function: copy_in
+ * -----------------
+ * Purpose: Copies n elements from an array into indexes index..index+n-1,
+ * splitting the copy where the slots wrap. The slots must be free.
+ * Parameters: pointer to CVector, first index, source array, number of elements
+ * Return values: void
+ */
+static void copy_in(CVector *cv, int index, const void *src, int n) {
+    size_t slot = cv->head + index;
+    if(slot >= cv->capacity) slot -= cv->capacity;
+    size_t first = cv->capacity - slot;
+    if(first > (size_t)n) first = n;
+    memcpy((char *)cv->data + slot*cv->elemsz, src, first*cv->elemsz);
+    memcpy(cv->data, (const char *)src + first*cv->elemsz, (n - first)*cv->elemsz);
+}
+
+/* Function: cvec_linearize
+ * ------------------------
+ * Purpose: Moves the elements so that element 0 is at slot 0. When the
+ * ring wraps, the shorter of its two runs is set aside in a temporary
+ * buffer while the longer one slides into place.
+ * Parameters: pointer to CVector
+ * Return values: void
+ */
+void cvec_linearize(CVector *cv) {
+    if(cv->head == 0) return;
+    char *data = cv->data;
+    size_t elemsz = cv->elemsz;
+
+    if(!wraps(cv, cv->size)) {
+        memmove(data, data + cv->head*elemsz, cv->size*elemsz);
+    } else {
+        size_t upper = cv->capacity - cv->head; // elements 0..upper-1, at the end
+        size_t lower = cv->size - upper; // the rest, from slot 0
+        if(lower <= upper) {
+            void *tmp = malloc(lower*elemsz);
+            assert(tmp != NULL);
+            memcpy(tmp, data, lower*elemsz);
+            memmove(data, data + cv->head*elemsz, upper*elemsz);
+            memcpy(data + upper*elemsz, tmp, lower*elemsz);
+            free(tmp);
+        } else {
+            void *tmp = malloc(upper*elemsz);
+            assert(tmp != NULL);
+            memcpy(tmp, data + cv->head*elemsz, upper*elemsz);
+            memmove(data + upper*elemsz, data, lower*elemsz);
+            memcpy(data, tmp, upper*elemsz);
+            free(tmp);
+        }
+    }
+    cv->head = 0;
+}
+
+#ifdef CVEC_USE_MREMAP
+/* Function: map_bytes
+ * -------------------
+ * Purpose: Rounds a byte count up to whole pages for mmap/mremap.
+ * Parameters: number of bytes
+ * Return values: page-multiple number of bytes
+ */
+static size_t map_bytes(size_t nbytes) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    return (nbytes + page - 1) / page * page;
+}
+#endif
+
+/* Function: free_data
+ * -------------------
+ * Purpose: Releases the element storage, however it was allocated.
+ * Inline storage is part of the CVector's own block and is not freed.
+ * Parameters: pointer to CVector
+ * Return values: void
+ */
+static void free_data(CVector *cv) {
+#ifdef CVEC_USE_MREMAP
+    if(cv->storage == CVEC_STORE_MAPPED) {
+        munmap(cv->data, cv->mapsz);
+        return;
+    }
+#endif
+    if(cv->storage == CVEC_STORE_HEAP) free(cv->data);
+}
+
+/* Function: cvec_resize
+ * ---------------------
+ * Purpose: Reallocates storage to hold exactly capacity elements.
+ * A capacity that fits the inline buffer (if the CVector has one) moves
+ * the elements back into it. Storage of CVEC_MMAP_THRESHOLD bytes or more
+ * is mapped directly and grown with mremap, which moves page mappings
+ * rather than copying the payload. Once mapped, storage stays mapped
+ * (capacity is rounded up to fill the last page) unless it shrinks back
+ * into the inline buffer. A wrapped ring is unwrapped first.
+ * Parameters: pointer to CVector, new capacity
+ * Return values: void
+ */
+static void cvec_resize(CVector *cv, size_t capacity) {
+    // every path below moves the live elements as one block from slot 0
+    cvec_linearize(cv);
+
+    size_t nbytes = cv->elemsz * capacity;
+    size_t live = cv->elemsz * cv->size;
+
+    if(capacity <= cv->inline_cap) {
+        if(cv->storage != CVEC_STORE_INLINE) {
+            if(live > 0) memcpy(cv->inline_buf, cv->data, live);
+            free_data(cv);
+            cv->data = cv->inline_buf;
+            cv->storage = CVEC_STORE_INLINE;
+        }
+        cv->capacity = cv->inline_cap;
+        return;
+    }
+
+#ifdef CVEC_USE_MREMAP
+    if(cv->storage == CVEC_STORE_MAPPED || nbytes >= CVEC_MMAP_THRESHOLD) {
+        size_t newsz = map_bytes(nbytes);
+        void *data;
+        if(cv->storage == CVEC_STORE_MAPPED) {
+            data = mremap(cv->data, cv->mapsz, newsz, MREMAP_MAYMOVE);
+            assert(data != MAP_FAILED);
+        } else {
+            // crossing the threshold: copy live elements once into a fresh mapping
+            data = mmap(NULL, newsz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            assert(data != MAP_FAILED);
+            if(live > 0) memcpy(data, cv->data, live);
+            free_data(cv);
+            cv->storage = CVEC_STORE_MAPPED;
+        }
+        cv->data = data;
+        cv->mapsz = newsz;
+        cv->capacity = newsz / cv->elemsz;
+        return;
+    }
+#endif
+
+    if(cv->storage == CVEC_STORE_INLINE) {
+        // spilling out of the inline buffer
+        void *data = malloc(nbytes);
+        assert(data != NULL);
+        memcpy(data, cv->data, live);
+        cv->data = data;
+        cv->storage = CVEC_STORE_HEAP;
+    } else {
+        cv->data = realloc(cv->data, nbytes);
+        // assert if allocation fails
+        assert(cv->data != NULL);
+    }
+    cv->capacity = capacity;
 }
 
 /* Function: cvec_create
@@ -47,23 +231,43 @@ void *get_nth(const CVector *cv, int n) {
  * Return values: pointer to CVector
  */
 CVector *cvec_create(size_t elemsz, size_t capacity_hint, CleanupElemFn fn) {
-    // allocates CVector in heap
-    CVector *cv = malloc(sizeof(CVector));
-    
-    // assert if elemsz is 0 and set struct field
+    return cvec_create_growth(elemsz, capacity_hint, fn, CVEC_GROW_DOUBLE, 0);
+}
+
+/* Function: cvec_create_growth
+ * ----------------------------
+ * Purpose: Allocates a vector in the heap with a chosen growth policy.
+ * Parameters: size of each vector element, capacity hint, cleanup callback
+ * function, growth policy, chunk size (CVEC_GROW_CHUNK only)
+ * Return values: pointer to CVector
+ */
+CVector *cvec_create_growth(size_t elemsz, size_t capacity_hint, CleanupElemFn fn,
+                            CVecGrowth growth, size_t chunk) {
+    // assert if elemsz is 0
     assert(elemsz != 0); // error message if false
-    cv->elemsz = elemsz; // arrow notation does dot operation and dereferencing
-    
+
     // check if capacity hint is 0 and handle with internal default
     if(capacity_hint == 0) capacity_hint = DEFAULT_CAPACITY;
-    
+
+    // a small vector keeps its elements in the same block as the struct
+    size_t inline_bytes = (capacity_hint * elemsz <= CVEC_INLINE_MAX) ? capacity_hint * elemsz : 0;
+
+    // allocates CVector in heap
+    CVector *cv = malloc(sizeof(CVector) + inline_bytes);
+    assert(cv != NULL);
+    assert(growth == CVEC_GROW_DOUBLE || growth == CVEC_GROW_HALF || growth == CVEC_GROW_CHUNK);
+    assert(growth != CVEC_GROW_CHUNK || chunk > 0);
+    cv->growth = growth;
+    cv->chunk = chunk;
+    cv->elemsz = elemsz; // arrow notation does dot operation and dereferencing
     cv->size = 0; // no data yet
+    cv->head = 0;
     cv->clean = fn;
-    cv->data = calloc(capacity_hint, elemsz);
-    cv->capacity = capacity_hint;
-    
-    // assert if allocation fails
-    assert(cv->data != NULL);
+    cv->data = NULL;
+    cv->storage = CVEC_STORE_HEAP;
+    cv->mapsz = 0;
+    cv->inline_cap = inline_bytes / elemsz;
+    cvec_resize(cv, capacity_hint);
     return cv;
 }
 
@@ -82,7 +286,7 @@ void cvec_dispose(CVector *cv) {
             ptr = NULL;
         }
     }
-    free(cv->data);
+    free_data(cv);
     // frees memory used for CVector storage
     free(cv);
 }
@@ -97,6 +301,18 @@ int cvec_count(const CVector *cv) {
     return cv->size;
 }
 
+/* Function: cvec_data
+ * -------------------
+ * Purpose: Gets pointer to the element storage, first making it
+ * contiguous if the ring wraps
+ * Parameters: pointer to CVector
+ * Return values: pointer to element 0
+ */
+void *cvec_data(CVector *cv) {
+    if(wraps(cv, cv->size)) cvec_linearize(cv);
+    return get_nth(cv, 0);
+}
+
 /* Function: cvec_nth
  * ------------------
  * Purpose: Performs pointer arithmetic to get nth index element in vector
@@ -109,18 +325,86 @@ void *cvec_nth(const CVector *cv, int index) {
     return get_nth(cv, index);
 }
 
-/* Function: cvec_expand
+/* Function: cvec_ensure
  * ---------------------
- * Purpose: Double the capacity of CVector once filled.
- * Parameters: pointer to CVector
+ * Purpose: Enlarges the capacity of CVector, following its growth policy,
+ * until it holds at least mincap elements. Does at most one reallocation.
+ * Parameters: pointer to CVector, minimum capacity needed
  * Return values: void
  */ 
-void cvec_expand(CVector *cv) {
-    // double the capacity
-    cv->capacity = cv->capacity * 2;
-    cv->data = realloc(cv->data, cv->elemsz * cv->capacity);
-    // assert if allocation fails
-    assert(cv->data != NULL);
+static void cvec_ensure(CVector *cv, size_t mincap) {
+    if(mincap <= cv->capacity) return;
+    size_t capacity = cv->capacity;
+    while(capacity < mincap) {
+        if(cv->growth == CVEC_GROW_DOUBLE) capacity *= 2;
+        else if(cv->growth == CVEC_GROW_HALF) capacity += capacity / 2 + 1;
+        else capacity += cv->chunk;
+    }
+    cvec_resize(cv, capacity);
+}
+
+/* Function: cvec_reserve
+ * ----------------------
+ * Purpose: Makes room for at least capacity elements in one reallocation.
+ * Parameters: pointer to CVector, capacity wanted
+ * Return values: void
+ */
+void cvec_reserve(CVector *cv, size_t capacity) {
+    // exact size requested, no policy rounding
+    if(capacity > cv->capacity) cvec_resize(cv, capacity);
+}
+
+/* Function: cvec_shrink_to_fit
+ * ----------------------------
+ * Purpose: Releases unused capacity.
+ * Parameters: pointer to CVector
+ * Return values: void
+ */
+void cvec_shrink_to_fit(CVector *cv) {
+    // keep room for one element so storage is never a zero-size allocation
+    size_t capacity = (cv->size > 0) ? cv->size : 1;
+    if(capacity < cv->capacity) cvec_resize(cv, capacity);
+}
+
+/* Function: cvec_capacity
+ * -----------------------
+ * Purpose: Gets number of elements CVector can hold without reallocating
+ * Parameters: pointer to CVector
+ * Return values: capacity in elements
+ */
+size_t cvec_capacity(const CVector *cv) {
+    return cv->capacity;
+}
+
+/* Function: cvec_insert_range
+ * ---------------------------
+ * Purpose: Inserts n values copied from an array starting at a given index.
+ * Grows capacity at most once and shifts the tail with a single memmove;
+ * inserting at index 0 moves head instead and shifts nothing.
+ * Parameters: pointer to CVector, address of first element to insert,
+ * number of elements, index to insert at
+ * Return values: void
+ */
+void cvec_insert_range(CVector *cv, const void *src, int n, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index <= cv->size);
+    assert(n >= 0);
+
+    cvec_ensure(cv, cv->size + n);
+
+    if(index == 0 && cv->size > 0) {
+        // open the gap before element 0 by moving head back; nothing shifts
+        cv->head = (cv->head >= n) ? cv->head - n : cv->head + cv->capacity - n;
+    } else if(index < cv->size) {
+        // the tail shifts as one block, so it must not wrap
+        if(wraps(cv, cv->size + n)) cvec_linearize(cv);
+        // memmove used since src and dest can overlap (unlike with memcpy)
+        // usage: memmove(dest addr, src addr, number of bytes to be moved)
+        memmove(get_nth(cv, index + n), get_nth(cv, index), 
+                (cv->elemsz) * (cv->size - index));
+    }
+    copy_in(cv, index, src, n);
+    cv->size += n;
 }
 
 /* Function: cvec_insert
@@ -130,43 +414,239 @@ void cvec_expand(CVector *cv) {
  * Return values: void
  */
 void cvec_insert(CVector *cv, const void *addr, int index) { 
-    // index out of bounds check
-    assert(index >= 0 && index <= cv->size);
+    cvec_insert_range(cv, addr, 1, index);
+}
+
+/* Function: cvec_append
+ * ---------------------
+ * Purpose: Appends a passed value to the end of the vector
+ * Parameters: pointer to CVector and address of element to apped
+ * Return values: void
+ */
+void cvec_append(CVector *cv, const void *addr) {
+    // nothing to shift at the end, just make room and copy
+    if(cv->size == cv->capacity) cvec_ensure(cv, cv->size + 1);
+    memcpy(get_nth(cv, cv->size), addr, cv->elemsz);
+    (cv->size)++;
+}
+
+/* Function: cvec_append_many
+ * --------------------------
+ * Purpose: Appends n values copied from an array to the end of the vector
+ * Parameters: pointer to CVector, address of first element, number of elements
+ * Return values: void
+ */
+void cvec_append_many(CVector *cv, const void *src, int n) {
+    assert(n >= 0);
+    cvec_ensure(cv, cv->size + n);
+    copy_in(cv, cv->size, src, n);
+    cv->size += n;
+}
+
+/* Function: cvec_push_front
+ * -------------------------
+ * Purpose: Prepends a passed value by moving head back one slot
+ * Parameters: pointer to CVector, address of element to prepend
+ * Return values: void
+ */
+void cvec_push_front(CVector *cv, const void *addr) {
+    if(cv->size == cv->capacity) cvec_ensure(cv, cv->size + 1);
+    cv->head = (cv->head == 0) ? cv->capacity - 1 : cv->head - 1;
+    memcpy(get_nth(cv, 0), addr, cv->elemsz);
+    (cv->size)++;
+}
 
-    // check if capacity needs to be enlarged
-    // keep buffer of 1, otherwise first arg of memmove might segfault on end insert
-    if(cv->size == cv->capacity) {
-        cvec_expand(cv);
+/* Function: take
+ * --------------
+ * Purpose: Hands a departing element to the client, or cleans it if the
+ * client did not ask for it.
+ * Parameters: pointer to CVector, pointer to element, destination or NULL
+ * Return values: void
+ */
+static void take(CVector *cv, void *ptr, void *addr) {
+    if(addr != NULL) memcpy(addr, ptr, cv->elemsz);
+    else if(cv->clean != NULL) cv->clean(ptr);
+}
+
+/* Function: cvec_pop_front
+ * ------------------------
+ * Purpose: Removes the first element by advancing head one slot
+ * Parameters: pointer to CVector, where to copy the element (or NULL)
+ * Return values: void
+ */
+void cvec_pop_front(CVector *cv, void *addr) {
+    assert(cv->size > 0);
+    take(cv, get_nth(cv, 0), addr);
+    cv->head = (cv->head + 1 == cv->capacity) ? 0 : cv->head + 1;
+    (cv->size)--;
+    if(cv->size == 0) cv->head = 0;
+}
+
+/* Function: cvec_pop_back
+ * -----------------------
+ * Purpose: Removes the last element
+ * Parameters: pointer to CVector, where to copy the element (or NULL)
+ * Return values: void
+ */
+void cvec_pop_back(CVector *cv, void *addr) {
+    assert(cv->size > 0);
+    take(cv, get_nth(cv, cv->size - 1), addr);
+    (cv->size)--;
+    if(cv->size == 0) cv->head = 0;
+}
+
+/* Function: cvec_span
+ * -------------------
+ * Purpose: Describes the elements as at most two contiguous runs
+ * Parameters: pointer to CVector, array of two spans to fill
+ * Return values: number of spans filled (0, 1 or 2)
+ */
+int cvec_span(const CVector *cv, CVecSpan spans[2]) {
+    if(cv->size == 0) return 0;
+    spans[0].data = get_nth(cv, 0);
+    if(!wraps(cv, cv->size)) {
+        spans[0].count = cv->size;
+        return 1;
     }
+    spans[0].count = cv->capacity - cv->head;
+    spans[1].data = cv->data;
+    spans[1].count = cv->size - spans[0].count;
+    return 2;
+}
 
-    // memmove used since src and dest can overlap (unlike with memcpy)
-    // usage: memmove(dest addr, src addr, number of bytes to be moved)i
-    memmove(get_nth(cv, index + 1), get_nth(cv, index), 
-            (cv->elemsz) * (cv->size - index));
+/* Function: cvec_replace
+ * ----------------------
+ * Purpose: Overwrites the element at a given index, cleaning the old one
+ * Parameters: pointer to CVector, address of new element, index to replace
+ * Return values: void
+ */
+void cvec_replace(CVector *cv, const void *addr, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index < cv->size);
+    void *ptr = get_nth(cv, index);
+    if(cv->clean != NULL) cv->clean(ptr);
+    memcpy(ptr, addr, cv->elemsz);
+}
 
-    // insert
-    memcpy(get_nth(cv, index), addr, cv->elemsz);
+/* Function: cvec_remove_range
+ * ---------------------------
+ * Purpose: Removes n elements starting at a given index, cleaning each one
+ * and closing the gap with a single memmove (none for a prefix or suffix).
+ * Parameters: pointer to CVector, index of first element, number of elements
+ * Return values: void
+ */
+void cvec_remove_range(CVector *cv, int index, int n) {
+    // range out of bounds check
+    assert(index >= 0 && n >= 0 && index + n <= cv->size);
 
-    // increment cv->size
-    (cv->size)++;
+    if(cv->clean != NULL) {
+        for(int i = index; i < index + n; i++) cv->clean(get_nth(cv, i));
+    }
+    if(index == 0) {
+        // dropping a prefix just advances head
+        cv->head += n;
+        if(cv->head >= cv->capacity) cv->head -= cv->capacity;
+    } else if(index + n < cv->size) {
+        // a suffix leaves nothing to move; anything else closes the gap
+        if(wraps(cv, cv->size)) cvec_linearize(cv);
+        memmove(get_nth(cv, index), get_nth(cv, index + n),
+                (cv->elemsz) * (cv->size - index - n));
+    }
+    cv->size -= n;
+    if(cv->size == 0) cv->head = 0;
 }
 
-/* Function: cvec_append
+/* Function: cvec_remove
  * ---------------------
- * Purpose: Appends a passed value to the end of the vector
- * Parameters: pointer to CVector and address of element to apped
+ * Purpose: Removes the element at a given index, shifting down the rest
+ * Parameters: pointer to CVector, index to remove
  * Return values: void
  */
-void cvec_append(CVector *cv, const void *addr) {
-    // appending is the same as inserting at end
-    cvec_insert(cv, addr, cvec_count(cv));
+void cvec_remove(CVector *cv, int index) {
+    cvec_remove_range(cv, index, 1);
+}
+
+/* Function: bound
+ * ---------------
+ * Purpose: Finds the first index in start..end-1 whose element does not
+ * sort before the key (lower bound), or, if upper is set, whose element
+ * sorts after the key (upper bound). Each step keeps one half of the
+ * range with a conditional move rather than a branch, so the loop runs
+ * the same number of steps whatever the outcomes and never mispredicts;
+ * both elements the next step might probe are prefetched while this
+ * step's compare runs.
+ * Parameters: pointer to CVector, address of key, compare callback
+ * function, start index, end index, whether to find the upper bound
+ * Return values: index, end if no element in range qualifies
+ */
+static int bound(const CVector *cv, const void *key, CompareFn cmp, int start, int end, bool upper) {
+    // skip past elements the key sorts after, or (for upper) not before,
+    // calling cmp(key, elem) in the same argument order as bsearch
+    int limit = upper ? -1 : 0;
+    size_t lo = start, len = end - start;
+    while(len > 1) {
+        size_t half = len / 2, next = (len - half) / 2;
+        if(next > 0) {
+            __builtin_prefetch(get_nth(cv, lo + next - 1));
+            __builtin_prefetch(get_nth(cv, lo + half + next - 1));
+        }
+        lo = (cmp(key, get_nth(cv, lo + half - 1)) > limit) ? lo + half : lo;
+        len -= half;
+    }
+    if(len == 1 && cmp(key, get_nth(cv, lo)) > limit) lo++;
+    return lo;
 }
 
-// implementation not required
-void cvec_replace(CVector *cv, const void *addr, int index) {}
+/* Function: cvec_lower_bound
+ * --------------------------
+ * Purpose: Finds where a key belongs in a sorted vector, before any equal elements
+ * Parameters: pointer to sorted CVector, address of key, compare callback function
+ * Return values: index of first element not less than key, or count
+ */
+int cvec_lower_bound(const CVector *cv, const void *keyaddr, CompareFn cmp) {
+    return bound(cv, keyaddr, cmp, 0, cv->size, false);
+}
 
-// implementation not required
-void cvec_remove(CVector *cv, int index) {}
+/* Function: cvec_upper_bound
+ * --------------------------
+ * Purpose: Finds where a key belongs in a sorted vector, after any equal elements
+ * Parameters: pointer to sorted CVector, address of key, compare callback function
+ * Return values: index of first element greater than key, or count
+ */
+int cvec_upper_bound(const CVector *cv, const void *keyaddr, CompareFn cmp) {
+    return bound(cv, keyaddr, cmp, 0, cv->size, true);
+}
+
+/* Function: cvec_equal_range
+ * --------------------------
+ * Purpose: Finds the run of elements equal to a key in a sorted vector.
+ * The upper bound is searched for only past the lower bound.
+ * Parameters: pointer to sorted CVector, address of key, compare callback
+ * function, addresses for first index and index past the run
+ * Return values: number of equal elements
+ */
+int cvec_equal_range(const CVector *cv, const void *keyaddr, CompareFn cmp, int *first, int *last) {
+    int lo = bound(cv, keyaddr, cmp, 0, cv->size, false);
+    int hi = bound(cv, keyaddr, cmp, lo, cv->size, true);
+    if(first != NULL) *first = lo;
+    if(last != NULL) *last = hi;
+    return hi - lo;
+}
+
+/* Function: cvec_insert_sorted
+ * ----------------------------
+ * Purpose: Inserts an element where it keeps a sorted vector sorted,
+ * after any equal elements, or not at all if unique and one is present
+ * Parameters: pointer to sorted CVector, address of new element, compare
+ * callback function, whether equal elements are refused
+ * Return values: index of new element, or -1 if refused
+ */
+int cvec_insert_sorted(CVector *cv, const void *addr, CompareFn cmp, bool unique) {
+    int index = bound(cv, addr, cmp, 0, cv->size, true);
+    if(unique && index > 0 && cmp(addr, get_nth(cv, index - 1)) == 0) return -1;
+    cvec_insert(cv, addr, index);
+    return index;
+}
 
 /* Function: cvec_search
  * ---------------------
@@ -179,21 +659,266 @@ int cvec_search(const CVector *cv, const void *key, CompareFn cmp, int start, bo
     // start index out of bounds check
     assert(start >= 0 && start <= cv->size);
 
+    if(sorted) {
+        // binary search, indexing through the ring so wrapping does not matter
+        int found = bound(cv, key, cmp, start, cv->size, false);
+        if(found < cv->size && cmp(key, get_nth(cv, found)) == 0) return found;
+        return -1;
+    }
+
+    if(wraps(cv, cv->size)) {
+        // lfind needs one block; index through the ring instead
+        for(int i = start; i < cv->size; i++) {
+            if(cmp(key, get_nth(cv, i)) == 0) return i;
+        }
+        return -1;
+    }
+
+    // linear search
+    // third arg passed by reference
     size_t num_searchelems = cvec_count(cv) - start;
+    char *ptr2 = (char *)lfind(key, get_nth(cv, start), &num_searchelems, cv->elemsz, cmp);
+    if(ptr2 == NULL) return -1;
+    return (ptr2 - (char *)get_nth(cv, 0))/(cv->elemsz);
+}
 
-    if(sorted) {
-        // binary search
-        char *ptr1 = (char *)bsearch(key, get_nth(cv, start), num_searchelems, cv->elemsz, cmp);
-        if(ptr1 == NULL) return -1;
-        return(ptr1 - (char *)(cv->data))/(cv->elemsz);
-    } else {
-        // linear search
-        // third arg passed by reference
-        char *ptr2 = (char *)lfind(key, get_nth(cv, start), &num_searchelems, cv->elemsz, cmp);
-        if(ptr2 == NULL) return -1;
-        return (ptr2 - (char *)(cv->data))/(cv->elemsz);
+/* Type: QuerySort
+ * ---------------
+ * How cvec_search_many sorts unsorted keys: as records holding a copy of
+ * the key (so comparisons do not chase pointers back into the client's
+ * array) followed by its position in that array. Records are a multiple
+ * of CVecMaxAlign so every copied key is suitably aligned for cmp.
+ */
+typedef struct {
+    CompareFn cmp;
+    size_t pos_offset; // where the position follows the key
+} QuerySort;
+
+static int query_pos(const void *rec, const QuerySort *qs) {
+    int pos;
+    memcpy(&pos, (const char *)rec + qs->pos_offset, sizeof(int));
+    return pos;
+}
+
+static int cmp_queries(const void *a, const void *b, void *arg) {
+    const QuerySort *qs = arg;
+    return qs->cmp(a, b);
+}
+
+/* Function: gallop
+ * ----------------
+ * Purpose: Finds the lower bound of a key that is known not to lie before
+ * index from, probing from, from+1, from+3, from+7, ... until an element
+ * does not sort before the key, then binary searching the last gap. Costs
+ * O(log d) compares for a lower bound d elements past from.
+ * Parameters: pointer to CVector, address of key, compare callback
+ * function, index to start from
+ * Return values: index of lower bound
+ */
+static int gallop(const CVector *cv, const void *key, CompareFn cmp, int from) {
+    size_t lo = from, step = 1, hi;
+    for(;;) {
+        hi = lo + step;
+        if(hi > cv->size) {
+            hi = cv->size;
+            break;
+        }
+        if(cmp(key, get_nth(cv, hi - 1)) <= 0) break;
+        lo = hi;
+        step *= 2;
     }
-    
+    return bound(cv, key, cmp, lo, hi, false);
+}
+
+/* Function: cvec_search_many
+ * --------------------------
+ * Purpose: Looks up many keys in a sorted vector with one forward pass.
+ * The keys are visited in sorted order (sorting copies of them if they
+ * are not already), and each search gallops forward from where the
+ * previous one ended.
+ * Parameters: pointer to sorted CVector, array of keys, number of keys,
+ * compare callback function, array for results
+ * Return values: void
+ */
+void cvec_search_many(const CVector *cv, const void *keys, int m, CompareFn cmp, int *found) {
+    assert(m >= 0);
+    const char *key = keys;
+    bool keys_sorted = true;
+    for(int i = 1; i < m && keys_sorted; i++) {
+        keys_sorted = cmp(key + (i-1)*cv->elemsz, key + i*cv->elemsz) <= 0;
+    }
+
+    QuerySort qs = { cmp, cv->elemsz };
+    size_t align = sizeof(CVecMaxAlign); // a multiple of its alignment
+    size_t recsz = (cv->elemsz + sizeof(int) + align - 1) / align * align;
+    char *recs = NULL;
+    if(!keys_sorted) {
+        recs = malloc(m * recsz);
+        assert(recs != NULL);
+        for(int i = 0; i < m; i++) {
+            memcpy(recs + i*recsz, key + i*cv->elemsz, cv->elemsz);
+            memcpy(recs + i*recsz + qs.pos_offset, &i, sizeof(int));
+        }
+        qsort_r(recs, m, recsz, cmp_queries, &qs);
+    }
+
+    int pos = 0;
+    for(int i = 0; i < m; i++) {
+        const void *k = keys_sorted ? key + i*cv->elemsz : recs + i*recsz;
+        int which = keys_sorted ? i : query_pos(k, &qs);
+        pos = gallop(cv, k, cmp, pos);
+        found[which] = (pos < cv->size && cmp(k, get_nth(cv, pos)) == 0) ? pos : -1;
+    }
+    free(recs);
+}
+
+/* Function: scan_eq
+ * -------------------
+ * Purpose: Finds the first element equal byte for byte to a key, one
+ * element at a time. Called with a constant size for common widths, so
+ * that once inlined the memcmp becomes one integer compare.
+ * Parameters: first element, number of elements, address of key, element size
+ * Return values: pointer to matching element, or NULL
+ */
+static inline const char *scan_eq(const char *p, size_t n, const void *key, size_t elemsz) {
+    for(size_t i = 0; i < n; i++, p += elemsz) {
+        if(memcmp(p, key, elemsz) == 0) return p;
+    }
+    return NULL;
+}
+
+static const char *find_eq_scalar(const char *p, size_t n, const void *key, size_t elemsz) {
+    switch(elemsz) {
+        case 1: return scan_eq(p, n, key, 1);
+        case 2: return scan_eq(p, n, key, 2);
+        case 4: return scan_eq(p, n, key, 4);
+        case 8: return scan_eq(p, n, key, 8);
+        default: return scan_eq(p, n, key, elemsz);
+    }
+}
+
+#ifdef CVEC_USE_SIMD
+/* Function: find_eq_sse2
+ * ----------------------
+ * Purpose: Compares 16 bytes of elements against the key per instruction.
+ * The compare sets every byte of a matching lane, so the lowest set bit
+ * of the byte mask is the first byte of the first match. SSE2 has no
+ * 64-bit compare; two 32-bit halves must both match instead.
+ * Parameters: first element, number of elements, address of key, element
+ * size (1, 2, 4 or 8)
+ * Return values: pointer to matching element, or NULL
+ */
+static const char *find_eq_sse2(const char *p, size_t n, const void *key, size_t elemsz) {
+    __m128i k;
+    switch(elemsz) {
+        case 1: k = _mm_set1_epi8(*(const char *)key); break;
+        case 2: { int16_t v; memcpy(&v, key, 2); k = _mm_set1_epi16(v); break; }
+        case 4: { int32_t v; memcpy(&v, key, 4); k = _mm_set1_epi32(v); break; }
+        default: { int64_t v; memcpy(&v, key, 8); k = _mm_set1_epi64x(v); break; }
+    }
+    size_t nbytes = n * elemsz, i = 0;
+    for(; i + 16 <= nbytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i)), eq;
+        if(elemsz == 1) eq = _mm_cmpeq_epi8(v, k);
+        else if(elemsz == 2) eq = _mm_cmpeq_epi16(v, k);
+        else if(elemsz == 4) eq = _mm_cmpeq_epi32(v, k);
+        else {
+            eq = _mm_cmpeq_epi32(v, k);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        }
+        int mask = _mm_movemask_epi8(eq);
+        if(mask != 0) return p + i + __builtin_ctz(mask);
+    }
+    return find_eq_scalar(p + i, (nbytes - i) / elemsz, key, elemsz);
+}
+
+/* Function: cmpeq_avx2
+ * --------------------
+ * Purpose: Compares 32 bytes of elements with the key, lane by lane
+ * Parameters: elements, key repeated in every lane, element size
+ * Return values: all ones in matching lanes, zero elsewhere
+ */
+__attribute__((target("avx2")))
+static inline __m256i cmpeq_avx2(__m256i v, __m256i k, size_t elemsz) {
+    if(elemsz == 1) return _mm256_cmpeq_epi8(v, k);
+    if(elemsz == 2) return _mm256_cmpeq_epi16(v, k);
+    if(elemsz == 4) return _mm256_cmpeq_epi32(v, k);
+    return _mm256_cmpeq_epi64(v, k);
+}
+
+/* Function: find_eq_avx2
+ * ----------------------
+ * Purpose: As find_eq_sse2, 64 bytes per loop in two 32-byte compares.
+ * Compiled for AVX2 and called only when the processor supports it.
+ * Parameters: first element, number of elements, address of key, element
+ * size (1, 2, 4 or 8)
+ * Return values: pointer to matching element, or NULL
+ */
+__attribute__((target("avx2")))
+static const char *find_eq_avx2(const char *p, size_t n, const void *key, size_t elemsz) {
+    __m256i k;
+    switch(elemsz) {
+        case 1: k = _mm256_set1_epi8(*(const char *)key); break;
+        case 2: { int16_t v; memcpy(&v, key, 2); k = _mm256_set1_epi16(v); break; }
+        case 4: { int32_t v; memcpy(&v, key, 4); k = _mm256_set1_epi32(v); break; }
+        default: { int64_t v; memcpy(&v, key, 8); k = _mm256_set1_epi64x(v); break; }
+    }
+    size_t nbytes = n * elemsz, i = 0;
+    for(; i + 64 <= nbytes; i += 64) {
+        __m256i eq0 = cmpeq_avx2(_mm256_loadu_si256((const __m256i *)(p + i)), k, elemsz);
+        __m256i eq1 = cmpeq_avx2(_mm256_loadu_si256((const __m256i *)(p + i + 32)), k, elemsz);
+        if(!_mm256_testz_si256(_mm256_or_si256(eq0, eq1), _mm256_or_si256(eq0, eq1))) {
+            unsigned mask0 = _mm256_movemask_epi8(eq0);
+            if(mask0 != 0) return p + i + __builtin_ctz(mask0);
+            return p + i + 32 + __builtin_ctz((unsigned)_mm256_movemask_epi8(eq1));
+        }
+    }
+    for(; i + 32 <= nbytes; i += 32) {
+        unsigned mask = _mm256_movemask_epi8(cmpeq_avx2(_mm256_loadu_si256((const __m256i *)(p + i)), k, elemsz));
+        if(mask != 0) return p + i + __builtin_ctz(mask);
+    }
+    return find_eq_scalar(p + i, (nbytes - i) / elemsz, key, elemsz);
+}
+#endif
+
+/* Function: find_eq
+ * -----------------
+ * Purpose: Picks the widest search the element size and processor allow.
+ * Parameters: first element, number of elements, address of key, element size
+ * Return values: pointer to matching element, or NULL
+ */
+static const char *find_eq(const char *p, size_t n, const void *key, size_t elemsz) {
+#ifdef CVEC_USE_SIMD
+    if(elemsz == 1 || elemsz == 2 || elemsz == 4 || elemsz == 8) {
+        if(__builtin_cpu_supports("avx2")) return find_eq_avx2(p, n, key, elemsz);
+        return find_eq_sse2(p, n, key, elemsz);
+    }
+#endif
+    return find_eq_scalar(p, n, key, elemsz);
+}
+
+/* Function: cvec_find_eq
+ * ----------------------
+ * Purpose: Finds the first element at or after start whose bytes equal
+ * the key's, searching each contiguous span of the ring in turn
+ * Parameters: pointer to CVector, address of key, start index
+ * Return values: index of matching element, or -1
+ */
+int cvec_find_eq(const CVector *cv, const void *keyaddr, int start) {
+    // start index out of bounds check
+    assert(start >= 0 && start <= cv->size);
+    CVecSpan spans[2];
+    int nspans = cvec_span(cv, spans), base = 0;
+    for(int s = 0; s < nspans; s++) {
+        if(start < base + spans[s].count) {
+            int from = (start > base) ? start - base : 0;
+            const char *p = (const char *)spans[s].data + from*cv->elemsz;
+            const char *hit = find_eq(p, spans[s].count - from, keyaddr, cv->elemsz);
+            if(hit != NULL) return base + from + (hit - p)/cv->elemsz;
+        }
+        base += spans[s].count;
+    }
+    return -1;
 }
 
 /* Function: cvec_sort
@@ -203,7 +928,500 @@ int cvec_search(const CVector *cv, const void *key, CompareFn cmp, int start, bo
  * Return values: void
  */
 void cvec_sort(CVector *cv, CompareFn cmp) { 
-    qsort(cv->data, cvec_count(cv), cv->elemsz, cmp);
+    if(wraps(cv, cv->size)) cvec_linearize(cv);
+    qsort(get_nth(cv, 0), cvec_count(cv), cv->elemsz, cmp);
+}
+
+/* Function: load_key
+ * ------------------
+ * Purpose: Reads an element's key and maps it to an unsigned integer that
+ * orders the same way: the sign bit of a signed key is flipped, and a
+ * negative float has all its bits flipped so larger magnitudes sort lower.
+ * Parameters: address of key, key width in bytes, kind of key
+ * Return values: key as an order-preserving unsigned integer
+ */
+static inline uint64_t load_key(const void *addr, size_t width, CVecKeyKind kind) {
+    uint64_t key, sign = (uint64_t)1 << (width * 8 - 1);
+    switch(width) {
+        case 1: { uint8_t k; memcpy(&k, addr, 1); key = k; break; }
+        case 2: { uint16_t k; memcpy(&k, addr, 2); key = k; break; }
+        case 4: { uint32_t k; memcpy(&k, addr, 4); key = k; break; }
+        default: { uint64_t k; memcpy(&k, addr, 8); key = k; break; }
+    }
+    if(kind == CVEC_KEY_SIGNED) return key ^ sign;
+    if(kind == CVEC_KEY_FLOAT) {
+        uint64_t mask = (width == 8) ? ~(uint64_t)0 : (sign << 1) - 1;
+        return (key & sign) ? key ^ mask : key ^ sign;
+    }
+    return key;
+}
+
+/* Function: insertion_sort_keyed
+ * ------------------------------
+ * Purpose: Stable insertion sort by key, for vectors too small to be
+ * worth the radix passes' counting and scratch array.
+ * Parameters: first element, number of elements, element size,
+ * key offset, key width, kind of key
+ * Return values: void
+ */
+static void insertion_sort_keyed(char *base, size_t n, size_t elemsz,
+                                 size_t key_offset, size_t key_width, CVecKeyKind kind) {
+    void *tmp = malloc(elemsz);
+    assert(tmp != NULL);
+    for(size_t i = 1; i < n; i++) {
+        uint64_t key = load_key(base + i*elemsz + key_offset, key_width, kind);
+        size_t j = i;
+        while(j > 0 && load_key(base + (j-1)*elemsz + key_offset, key_width, kind) > key) j--;
+        if(j == i) continue;
+        memcpy(tmp, base + i*elemsz, elemsz);
+        memmove(base + (j+1)*elemsz, base + j*elemsz, (i-j)*elemsz);
+        memcpy(base + j*elemsz, tmp, elemsz);
+    }
+    free(tmp);
+}
+
+/* Function: scatter
+ * -----------------
+ * Purpose: One radix pass: copies each element to the next position for
+ * its digit. Called with constant sizes for common layouts, so that once
+ * inlined the key load and element copy become plain moves.
+ * Parameters: source and destination arrays, number of elements, element
+ * size, key offset, key width, kind of key, digit shift, next position
+ * for each digit value
+ * Return values: void
+ */
+static inline void scatter(const char *src, char *dst, size_t n, size_t elemsz,
+                           size_t key_offset, size_t key_width, CVecKeyKind kind,
+                           int shift, size_t *pos) {
+    for(size_t i = 0; i < n; i++) {
+        const char *elem = src + i*elemsz;
+        uint64_t key = load_key(elem + key_offset, key_width, kind);
+        memcpy(dst + pos[(key >> shift) & (RADIX_SIZE - 1)]++ * elemsz, elem, elemsz);
+    }
+}
+
+/* Type: KeySort
+ * -------------
+ * How cvec_sort_keyed sorts keys of widths the radix passes do not
+ * handle: as records holding a copy of the element followed by its
+ * original position, so that qsort_r can break ties by position and the
+ * sort stays stable. Records are a multiple of CVecMaxAlign.
+ */
+typedef struct {
+    size_t key_offset, key_width;
+    CVecKeyKind kind;
+    size_t pos_offset; // where the position follows the element
+} KeySort;
+
+/* Function: cmp_wide_keys
+ * -----------------------
+ * Purpose: Compares the integer keys of two records byte by byte from
+ * the most significant, in the machine's byte order, with the sign bit
+ * of a signed key flipped, then compares positions if the keys are equal
+ * Parameters: two records, pointer to KeySort
+ * Return values: negative, zero or positive as for a CompareFn
+ */
+static int cmp_wide_keys(const void *a, const void *b, void *arg) {
+    const KeySort *ks = arg;
+    const unsigned char *ka = (const unsigned char *)a + ks->key_offset;
+    const unsigned char *kb = (const unsigned char *)b + ks->key_offset;
+    for(size_t i = 0; i < ks->key_width; i++) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        size_t byte = ks->key_width - 1 - i;
+#else
+        size_t byte = i;
+#endif
+        unsigned flip = (i == 0 && ks->kind == CVEC_KEY_SIGNED) ? 0x80 : 0;
+        unsigned ca = ka[byte] ^ flip, cb = kb[byte] ^ flip;
+        if(ca != cb) return (ca > cb) - (ca < cb);
+    }
+    int pa, pb;
+    memcpy(&pa, (const char *)a + ks->pos_offset, sizeof(int));
+    memcpy(&pb, (const char *)b + ks->pos_offset, sizeof(int));
+    return (pa > pb) - (pa < pb);
+}
+
+/* Function: sort_wide_keyed
+ * -------------------------
+ * Purpose: Stable comparison sort for integer keys of any width, used by
+ * cvec_sort_keyed when the width is not 1, 2, 4 or 8
+ * Parameters: first element, number of elements, element size, key
+ * offset, key width, kind of key
+ * Return values: void
+ */
+static void sort_wide_keyed(char *base, size_t n, size_t elemsz,
+                            size_t key_offset, size_t key_width, CVecKeyKind kind) {
+    KeySort ks = { key_offset, key_width, kind, elemsz };
+    size_t align = sizeof(CVecMaxAlign); // a multiple of its alignment
+    size_t recsz = (elemsz + sizeof(int) + align - 1) / align * align;
+    char *recs = malloc(n * recsz);
+    assert(recs != NULL);
+    for(size_t i = 0; i < n; i++) {
+        int pos = i;
+        memcpy(recs + i*recsz, base + i*elemsz, elemsz);
+        memcpy(recs + i*recsz + ks.pos_offset, &pos, sizeof(int));
+    }
+    qsort_r(recs, n, recsz, cmp_wide_keys, &ks);
+    for(size_t i = 0; i < n; i++) memcpy(base + i*elemsz, recs + i*recsz, elemsz);
+    free(recs);
+}
+
+/* Function: cvec_sort_keyed
+ * -------------------------
+ * Purpose: Sorts by a fixed-width key inside each element with an LSD
+ * radix sort on RADIX_BITS-bit digits: one pass counts every digit, then
+ * each digit from least to most significant scatters the elements into a
+ * scratch array and back. Passes in which every element has the same
+ * digit are skipped.
+ * Small vectors are insertion sorted instead, and integer keys of other
+ * widths are sorted by comparison. All paths are stable.
+ * Parameters: pointer to CVector, byte offset of key in element,
+ * key width in bytes, kind of key
+ * Return values: void
+ */
+void cvec_sort_keyed(CVector *cv, size_t key_offset, size_t key_width, CVecKeyKind kind) {
+    assert(kind != CVEC_KEY_FLOAT || key_width == 4 || key_width == 8);
+    assert(key_width > 0 && key_offset + key_width <= cv->elemsz);
+
+    if(wraps(cv, cv->size)) cvec_linearize(cv);
+    size_t n = cv->size, elemsz = cv->elemsz;
+    char *src = get_nth(cv, 0);
+
+    if(key_width != 1 && key_width != 2 && key_width != 4 && key_width != 8) {
+        sort_wide_keyed(src, n, elemsz, key_offset, key_width, kind);
+        return;
+    }
+
+    if(n < RADIX_MIN) {
+        insertion_sort_keyed(src, n, elemsz, key_offset, key_width, kind);
+        return;
+    }
+
+    size_t npasses = (key_width * 8 + RADIX_BITS - 1) / RADIX_BITS;
+    size_t (*counts)[RADIX_SIZE] = calloc(npasses, sizeof(*counts));
+    assert(counts != NULL);
+    for(size_t i = 0; i < n; i++) {
+        uint64_t key = load_key(src + i*elemsz + key_offset, key_width, kind);
+        for(size_t d = 0; d < npasses; d++) counts[d][(key >> (RADIX_BITS*d)) & (RADIX_SIZE - 1)]++;
+    }
+
+    char *dst = malloc(n * elemsz);
+    assert(dst != NULL);
+    char *orig = src, *scratch = dst;
+    for(size_t d = 0; d < npasses; d++) {
+        int shift = RADIX_BITS*d;
+        uint64_t first = load_key(src + key_offset, key_width, kind);
+        if(counts[d][(first >> shift) & (RADIX_SIZE - 1)] == n) continue; // digit is the same everywhere
+
+        // turn counts into starting positions
+        size_t pos = 0;
+        for(int b = 0; b < RADIX_SIZE; b++) {
+            size_t c = counts[d][b];
+            counts[d][b] = pos;
+            pos += c;
+        }
+        if(elemsz == 4 && key_width == 4)
+            scatter(src, dst, n, 4, key_offset, 4, kind, shift, counts[d]);
+        else if(elemsz == 8 && key_width == 8)
+            scatter(src, dst, n, 8, key_offset, 8, kind, shift, counts[d]);
+        else if(elemsz == 8 && key_width == 4)
+            scatter(src, dst, n, 8, key_offset, 4, kind, shift, counts[d]);
+        else if(elemsz == 16 && key_width == 8)
+            scatter(src, dst, n, 16, key_offset, 8, kind, shift, counts[d]);
+        else
+            scatter(src, dst, n, elemsz, key_offset, key_width, kind, shift, counts[d]);
+        char *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    // an odd number of passes leaves the result in scratch
+    if(src != orig) memcpy(orig, src, n * elemsz);
+    free(scratch);
+    free(counts);
+}
+
+/* Function: swap_elems
+ * ---------------------
+ * Purpose: Exchanges two elements through a small stack buffer, a piece
+ * at a time for large elements.
+ * Parameters: addresses of the two elements, element size
+ * Return values: void
+ */
+static void swap_elems(void *a, void *b, size_t elemsz) {
+    char tmp[64];
+    char *p = a, *q = b;
+    for(size_t off = 0; off < elemsz; off += sizeof(tmp)) {
+        size_t len = (elemsz - off < sizeof(tmp)) ? elemsz - off : sizeof(tmp);
+        memcpy(tmp, p + off, len);
+        memcpy(p + off, q + off, len);
+        memcpy(q + off, tmp, len);
+    }
+}
+
+/* Function: select_nth
+ * --------------------
+ * Purpose: Introselect: partitions around a median-of-3 pivot and keeps
+ * only the side holding position k, until the range is small enough to
+ * insertion sort. If partitioning goes badly for 2lgN rounds (inputs
+ * built to defeat the pivot choice), the rest of the range is sorted
+ * instead, bounding the worst case at NlgN.
+ * Parameters: first element, number of elements, position wanted,
+ * element size, compare callback function
+ * Return values: void
+ */
+static void select_nth(char *base, size_t n, size_t k, size_t elemsz, CompareFn cmp) {
+    size_t lo = 0, hi = n;
+    int depth = 2 * (63 - __builtin_clzl(n | 1));
+    while(hi - lo > SELECT_INSERTION) {
+        if(depth-- == 0) {
+            qsort(base + lo*elemsz, hi - lo, elemsz, cmp);
+            return;
+        }
+        // order lo, mid, last; the median becomes the pivot at lo, leaving
+        // an element no greater at mid and one no less at last as sentinels
+        char *first = base + lo*elemsz, *mid = base + (lo + (hi - lo)/2)*elemsz;
+        char *last = base + (hi - 1)*elemsz;
+        if(cmp(mid, first) < 0) swap_elems(mid, first, elemsz);
+        if(cmp(last, mid) < 0) {
+            swap_elems(last, mid, elemsz);
+            if(cmp(mid, first) < 0) swap_elems(mid, first, elemsz);
+        }
+        swap_elems(first, mid, elemsz);
+
+        // Hoare partition; scans stop on elements equal to the pivot so
+        // runs of duplicates split evenly
+        size_t i = lo, j = hi;
+        for(;;) {
+            while(cmp(base + (++i)*elemsz, first) < 0) ;
+            while(cmp(base + (--j)*elemsz, first) > 0) ;
+            if(i >= j) break;
+            swap_elems(base + i*elemsz, base + j*elemsz, elemsz);
+        }
+        swap_elems(first, base + j*elemsz, elemsz); // pivot to its sorted position j
+        if(k == j) return;
+        if(k < j) hi = j;
+        else lo = j + 1;
+    }
+    for(size_t i = lo + 1; i < hi; i++) {
+        for(size_t j = i; j > lo && cmp(base + (j-1)*elemsz, base + j*elemsz) > 0; j--)
+            swap_elems(base + (j-1)*elemsz, base + j*elemsz, elemsz);
+    }
+}
+
+/* Function: cvec_nth_element
+ * --------------------------
+ * Purpose: Moves the element that sorting would put at index n there,
+ * with no greater elements before it and no lesser ones after
+ * Parameters: pointer to CVector, index, callback compare function
+ * Return values: void
+ */
+void cvec_nth_element(CVector *cv, int n, CompareFn cmp) {
+    assert(n >= 0 && n < cv->size);
+    if(wraps(cv, cv->size)) cvec_linearize(cv);
+    select_nth(get_nth(cv, 0), cv->size, n, cv->elemsz, cmp);
+}
+
+/* Function: cvec_partial_sort
+ * ---------------------------
+ * Purpose: Sorts the k least elements into indexes 0..k-1 by selecting
+ * them, then sorting only those
+ * Parameters: pointer to CVector, number of elements to sort, callback
+ * compare function
+ * Return values: void
+ */
+void cvec_partial_sort(CVector *cv, int k, CompareFn cmp) {
+    assert(k >= 0 && k <= cv->size);
+    if(wraps(cv, cv->size)) cvec_linearize(cv);
+    char *base = get_nth(cv, 0);
+    if(k < cv->size) select_nth(base, cv->size, k, cv->elemsz, cmp);
+    qsort(base, k, cv->elemsz, cmp);
+}
+
+/* Function: sift_up
+ * -----------------
+ * Purpose: Moves the element at index i toward the root of a d-ary
+ * max-heap, where the children of i are at d*i+1 .. d*i+d, until its
+ * parent does not sort before it. Called with constant d so the
+ * arithmetic compiles to shifts.
+ * Parameters: pointer to CVector, index, arity, callback compare function
+ * Return values: void
+ */
+static inline void sift_up(CVector *cv, size_t i, size_t d, CompareFn cmp) {
+    while(i > 0) {
+        size_t parent = (i - 1) / d;
+        void *p = get_nth(cv, parent), *c = get_nth(cv, i);
+        if(cmp(p, c) >= 0) break;
+        swap_elems(p, c, cv->elemsz);
+        i = parent;
+    }
+}
+
+/* Function: sift_down
+ * -------------------
+ * Purpose: Moves the element at index i away from the root of a d-ary
+ * max-heap of n elements, swapping it with its greatest child until no
+ * child sorts after it. The d children are adjacent, so for small
+ * elements a 4-ary heap finds the greatest in one or two cache lines
+ * while descending half as many levels as a binary heap.
+ * Parameters: pointer to CVector, index, number of heap elements, arity,
+ * callback compare function
+ * Return values: void
+ */
+static inline void sift_down(CVector *cv, size_t i, size_t n, size_t d, CompareFn cmp) {
+    for(;;) {
+        size_t first = d*i + 1;
+        if(first >= n) break;
+        size_t end = (n - first < d) ? n : first + d, best = first;
+        void *bestp = get_nth(cv, first);
+        for(size_t c = first + 1; c < end; c++) {
+            void *cp = get_nth(cv, c);
+            if(cmp(cp, bestp) > 0) {
+                best = c;
+                bestp = cp;
+            }
+        }
+        void *ip = get_nth(cv, i);
+        if(cmp(bestp, ip) <= 0) break;
+        swap_elems(bestp, ip, cv->elemsz);
+        i = best;
+    }
+}
+
+/* Function: heapify
+ * -----------------
+ * Purpose: Builds a d-ary max-heap bottom-up, sifting down every element
+ * that has children, last first
+ * Parameters: pointer to CVector, arity, callback compare function
+ * Return values: void
+ */
+static inline void heapify(CVector *cv, size_t d, CompareFn cmp) {
+    if(cv->size < 2) return;
+    for(size_t i = (cv->size - 2) / d + 1; i-- > 0; ) sift_down(cv, i, cv->size, d, cmp);
+}
+
+/* Function: heap_push
+ * -------------------
+ * Purpose: Appends an element to a d-ary max-heap and sifts it up
+ * Parameters: pointer to CVector, address of new element, arity,
+ * callback compare function
+ * Return values: void
+ */
+static inline void heap_push(CVector *cv, const void *addr, size_t d, CompareFn cmp) {
+    cvec_append(cv, addr);
+    sift_up(cv, cv->size - 1, d, cmp);
+}
+
+/* Function: heap_pop
+ * ------------------
+ * Purpose: Removes the root of a d-ary max-heap: swaps it with the last
+ * element, pops it from the back and sifts the new root down
+ * Parameters: pointer to CVector, where to copy the element (or NULL),
+ * arity, callback compare function
+ * Return values: void
+ */
+static inline void heap_pop(CVector *cv, void *addr, size_t d, CompareFn cmp) {
+    assert(cv->size > 0);
+    swap_elems(get_nth(cv, 0), get_nth(cv, cv->size - 1), cv->elemsz);
+    cvec_pop_back(cv, addr);
+    sift_down(cv, 0, cv->size, d, cmp);
+}
+
+/* Function: cvec_heapify
+ * ----------------------
+ * Purpose: Arranges the vector as a binary max-heap
+ * Parameters: pointer to CVector, callback compare function
+ * Return values: void
+ */
+void cvec_heapify(CVector *cv, CompareFn cmp) {
+    heapify(cv, 2, cmp);
+}
+
+/* Function: cvec_heap_push
+ * ------------------------
+ * Purpose: Adds an element to a binary max-heap
+ * Parameters: pointer to CVector, address of new element, callback compare function
+ * Return values: void
+ */
+void cvec_heap_push(CVector *cv, const void *addr, CompareFn cmp) {
+    heap_push(cv, addr, 2, cmp);
+}
+
+/* Function: cvec_heap_pop
+ * -----------------------
+ * Purpose: Removes the greatest element from a binary max-heap
+ * Parameters: pointer to CVector, where to copy the element (or NULL),
+ * callback compare function
+ * Return values: void
+ */
+void cvec_heap_pop(CVector *cv, void *addr, CompareFn cmp) {
+    heap_pop(cv, addr, 2, cmp);
+}
+
+/* Function: cvec_heapify4
+ * -----------------------
+ * Purpose: Arranges the vector as a 4-ary max-heap
+ * Parameters: pointer to CVector, callback compare function
+ * Return values: void
+ */
+void cvec_heapify4(CVector *cv, CompareFn cmp) {
+    heapify(cv, 4, cmp);
+}
+
+/* Function: cvec_heap4_push
+ * -------------------------
+ * Purpose: Adds an element to a 4-ary max-heap
+ * Parameters: pointer to CVector, address of new element, callback compare function
+ * Return values: void
+ */
+void cvec_heap4_push(CVector *cv, const void *addr, CompareFn cmp) {
+    heap_push(cv, addr, 4, cmp);
+}
+
+/* Function: cvec_heap4_pop
+ * ------------------------
+ * Purpose: Removes the greatest element from a 4-ary max-heap
+ * Parameters: pointer to CVector, where to copy the element (or NULL),
+ * callback compare function
+ * Return values: void
+ */
+void cvec_heap4_pop(CVector *cv, void *addr, CompareFn cmp) {
+    heap_pop(cv, addr, 4, cmp);
+}
+
+/* Function: cvec_topk_add
+ * -----------------------
+ * Purpose: Offers one element to a vector that keeps the k least elements
+ * seen, as a binary max-heap so the one to evict is at index 0
+ * Parameters: pointer to top-k CVector, bound k, address of element,
+ * callback compare function
+ * Return values: true if the element was copied in
+ */
+bool cvec_topk_add(CVector *top, int k, const void *addr, CompareFn cmp) {
+    assert(k >= 0 && top->size <= k);
+    if(top->size < k) {
+        heap_push(top, addr, 2, cmp);
+        return true;
+    }
+    if(k == 0 || cmp(addr, get_nth(top, 0)) >= 0) return false;
+    cvec_replace(top, addr, 0);
+    sift_down(top, 0, top->size, 2, cmp);
+    return true;
+}
+
+/* Function: cvec_topk
+ * -------------------
+ * Purpose: Streams a vector through cvec_topk_add and sorts what is kept
+ * Parameters: pointer to CVector, number of elements wanted, callback
+ * compare function
+ * Return values: new CVector of the k least elements in ascending order
+ */
+CVector *cvec_topk(const CVector *cv, int k, CompareFn cmp) {
+    assert(k >= 0);
+    int kept = (k < cv->size) ? k : cv->size;
+    CVector *top = cvec_create(cv->elemsz, kept, NULL);
+    for(int i = 0; i < cv->size; i++) cvec_topk_add(top, kept, get_nth(cv, i), cmp);
+    cvec_sort(top, cmp);
+    return top;
 }
 
 /* Function: cvec_first
@@ -215,7 +1433,7 @@ void cvec_sort(CVector *cv, CompareFn cmp) {
 void *cvec_first(const CVector *cv) { 
     // empty CVector
     if(cv->size == 0) return NULL; 
-    else return cv->data;
+    else return get_nth(cv, 0);
 }
 
 /* Function: cvec_next
@@ -226,6 +1444,8 @@ void *cvec_first(const CVector *cv) {
  */
 void *cvec_next(const CVector *cv, const void *prev) {
     // to handle reaching end of populated array
-    if(prev == (char *)cv->data + cv->elemsz*(cvec_count(cv) - 1)) return NULL;
-    return (char *)prev + cv->elemsz; // works because data is stored in contiguous memory 
+    if(prev == get_nth(cv, cvec_count(cv) - 1)) return NULL;
+    char *next = (char *)prev + cv->elemsz; // storage is contiguous up to its end
+    // past the last slot the ring continues at slot 0
+    return (next == (char *)cv->data + cv->elemsz*cv->capacity) ? cv->data : next;
 }
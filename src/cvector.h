@@ -55,6 +55,28 @@ typedef int (*CompareFn)(const void *addr1, const void *addr2);
 typedef void (*CleanupElemFn)(void *addr);
 
 
+/**
+ * Type: CVecGrowth
+ * ----------------
+ * CVecGrowth selects how a CVector enlarges its capacity when it runs out
+ * of room (see cvec_create_growth).
+ *
+ *   CVEC_GROW_DOUBLE  capacity doubles; the fewest reallocations, but up
+ *                     to half of the storage can sit unused.
+ *   CVEC_GROW_HALF    capacity grows by half; more reallocations, at most
+ *                     a third of the storage unused.
+ *   CVEC_GROW_CHUNK   capacity grows by a fixed number of elements; waste
+ *                     is bounded by the chunk, but appending n elements
+ *                     copies O(n^2/chunk) bytes in total, so choose a
+ *                     chunk that is large relative to the final count.
+ */
+typedef enum {
+    CVEC_GROW_DOUBLE,
+    CVEC_GROW_HALF,
+    CVEC_GROW_CHUNK
+} CVecGrowth;
+
+
 /**
  * Type: CVector
  * -------------
@@ -94,7 +116,13 @@ typedef struct CVectorImplementation CVector;
  * will result in an appropriately large initial allocation and fewer resizing 
  * operations later. For a small vector, a small capacity_hint will result in 
  * several smaller allocations and potentially less waste. If capacity_hint 
- * is 0, an internal default value is used. 
+ * is 0, an internal default value is used. A CVector whose initial
+ * storage is small (CVEC_INLINE_MAX, 256 bytes) is created with a single
+ * allocation that holds both the CVector and its elements; it moves its
+ * elements to separate storage only if it outgrows the initial capacity.
+ * On Linux, storage of 64MB or more (CVEC_MMAP_THRESHOLD) is mapped
+ * directly from the operating system and enlarged with mremap, so growing
+ * a huge CVector moves page mappings instead of copying every element.
  * 
  * The fn parameter is a client callback function to cleanup an element. This
  * function will be called on an element being removed/replaced (via 
@@ -110,6 +138,24 @@ typedef struct CVectorImplementation CVector;
 CVector *cvec_create(size_t elemsz, size_t capacity_hint, CleanupElemFn fn);
 
 
+/**
+ * Function: cvec_create_growth
+ * Usage: CVector *v = cvec_create_growth(sizeof(int), 0, NULL, CVEC_GROW_HALF, 0)
+ * -------------------------------------------------------------------------------
+ * Creates a new empty CVector like cvec_create, but with the given growth
+ * policy instead of doubling. The chunk parameter is the number of
+ * elements added at each enlargement for CVEC_GROW_CHUNK and is ignored
+ * for the other policies. cvec_create(elemsz, hint, fn) is the same as
+ * cvec_create_growth(elemsz, hint, fn, CVEC_GROW_DOUBLE, 0).
+ *
+ * Asserts: zero elemsz, invalid growth, zero chunk for CVEC_GROW_CHUNK,
+ *          allocation failure
+ * Assumes: cleanup fn is valid
+ */
+CVector *cvec_create_growth(size_t elemsz, size_t capacity_hint, CleanupElemFn fn,
+                            CVecGrowth growth, size_t chunk);
+
+
 /**
  * Function: cvec_dispose
  * Usage: cvec_dispose(v)
@@ -130,6 +176,44 @@ void cvec_dispose(CVector *cv);
 int cvec_count(const CVector *cv);
 
 
+/**
+ * Function: cvec_capacity
+ * Usage: size_t cap = cvec_capacity(v)
+ * ------------------------------------
+ * Returns the number of elements the CVector can hold before it must
+ * enlarge its storage. Operates in constant-time.
+ */
+size_t cvec_capacity(const CVector *cv);
+
+
+/**
+ * Function: cvec_reserve
+ * Usage: cvec_reserve(v, 1000000)
+ * -------------------------------
+ * Ensures the CVector's storage can hold at least capacity elements,
+ * enlarging it to exactly that capacity in a single reallocation if
+ * needed. Reserving ahead of a known number of appends avoids the
+ * repeated copying of incremental growth. Never reduces the capacity.
+ * Like any enlargement, it invalidates pointers into the CVector.
+ * An assert is raised on allocation failure. Operates in linear-time.
+ *
+ * Asserts: allocation failure
+ */
+void cvec_reserve(CVector *cv, size_t capacity);
+
+
+/**
+ * Function: cvec_shrink_to_fit
+ * Usage: cvec_shrink_to_fit(v)
+ * ----------------------------
+ * Reduces the CVector's storage to the number of elements it currently
+ * holds, releasing the unused capacity left by growth. A later append
+ * will enlarge the storage again. Invalidates pointers into the CVector.
+ * Operates in linear-time.
+ */
+void cvec_shrink_to_fit(CVector *cv);
+
+
 /**
  * Function: cvec_nth
  * Usage: int num = *(int *)cvec_nth(v, 0)
@@ -149,6 +233,26 @@ int cvec_count(const CVector *cv);
 void *cvec_nth(const CVector *cv, int index);
 
 
+/**
+ * Function: cvec_data
+ * Usage: int *nums = cvec_data(v)
+ * -------------------------------
+ * Returns a pointer to the CVector's internal storage, where the elements
+ * are stored contiguously in index order: element i is at
+ * (char *)cvec_data(v) + i*elemsz. This gives a client loop (or a library
+ * routine such as memcpy or a sort) direct access to all elements at once
+ * without a call per element. The pointer is subject to the same rules as
+ * one returned by cvec_nth and becomes invalid during any call that adds,
+ * removes, or rearranges elements. For an empty CVector the pointer must
+ * not be dereferenced. Operates in constant-time, unless the elements
+ * wrap around the end of storage (see cvec_push_front), in which case
+ * they are first moved into one block in linear-time, invalidating
+ * pointers to them; this is why the CVector is not const. cvec_span
+ * gives access without moving them.
+ */
+void *cvec_data(CVector *cv);
+
+
 /**
  * Function: cvec_insert
  * Usage: cvec_insert(v, &elem, 0)
@@ -160,7 +264,9 @@ void *cvec_nth(const CVector *cv, int index);
  * int elements, addr should be the memory location where the desired int 
  * value is stored. The value at that location is copied into internal 
  * CVector storage. The capacity is enlarged if necessary, an assert is raised
- * on allocation failure. Operates in linear-time.
+ * on allocation failure. Operates in linear-time, except that inserting
+ * at index 0 of a non-empty CVector is constant-time (amortized), as
+ * for cvec_push_front.
  *
  * Asserts: invalid index, allocation failure
  * Assumes: address of valid elem
@@ -182,6 +288,157 @@ void cvec_insert(CVector *cv, const void *addr, int index);
  */
 void cvec_append(CVector *cv, const void *addr);
 
+
+/**
+ * Function: cvec_append_many
+ * Usage: cvec_append_many(v, array, n)
+ * ------------------------------------
+ * Appends n elements to the end of the CVector, copying them from the
+ * array at src (n * elemsz contiguous bytes). The capacity is enlarged
+ * at most once, so bulk loading runs at memcpy speed. src must not point
+ * into this CVector's own storage. An assert is raised if n is negative
+ * or on allocation failure. Operates in linear-time in n (amortized).
+ *
+ * Asserts: negative n, allocation failure
+ * Assumes: src is a valid array of n elements
+ */
+void cvec_append_many(CVector *cv, const void *src, int n);
+
+
+/**
+ * Function: cvec_insert_range
+ * Usage: cvec_insert_range(v, array, n, 0)
+ * ----------------------------------------
+ * Inserts n elements copied from the array at src into the CVector,
+ * placing the first at the given index and shifting up the elements
+ * after it to make room. The capacity is enlarged at most once and the
+ * existing elements are shifted with a single move. An assert is raised
+ * if index is less than 0 or greater than the count, if n is negative,
+ * or on allocation failure. src must not point into this CVector's own
+ * storage. Operates in linear-time.
+ *
+ * Asserts: invalid index, negative n, allocation failure
+ * Assumes: src is a valid array of n elements
+ */
+void cvec_insert_range(CVector *cv, const void *src, int n, int index);
+
+
+/**
+ * Function: cvec_replace
+ * Usage: cvec_replace(v, &elem, 0)
+ * --------------------------------
+ * Overwrites the element at the given index with a new value. Before
+ * being overwritten, the client's cleanup function is called on the old
+ * element. addr is expected to be a valid pointer to an element; the
+ * value at that location is copied into internal CVector storage. An
+ * assert is raised if index is less than 0 or greater than the count
+ * minus one. Operates in constant-time.
+ *
+ * Asserts: invalid index
+ * Assumes: address of valid elem
+ */
+void cvec_replace(CVector *cv, const void *addr, int index);
+
+
+/**
+ * Function: cvec_remove
+ * Usage: cvec_remove(v, 3)
+ * ------------------------
+ * Removes the element at the given index from the CVector and shifts
+ * other elements down to close the gap. The client's cleanup function is
+ * called on the removed element. An assert is raised if index is less
+ * than 0 or greater than the count minus one. Operates in linear-time,
+ * except that removing index 0 is constant-time.
+ *
+ * Asserts: invalid index
+ */
+void cvec_remove(CVector *cv, int index);
+
+
+/**
+ * Function: cvec_remove_range
+ * Usage: cvec_remove_range(v, 10, 5)
+ * ----------------------------------
+ * Removes n consecutive elements starting at the given index and shifts
+ * the following elements down with a single move. The client's cleanup
+ * function is called on each removed element. An assert is raised if
+ * the range is not within 0 to count. Operates in linear-time; a range
+ * starting at index 0 or ending at the count shifts nothing and costs
+ * only the cleanup calls.
+ *
+ * Asserts: invalid range
+ */
+void cvec_remove_range(CVector *cv, int index, int n);
+
+
+/**
+ * Functions: cvec_push_front, cvec_pop_front, cvec_pop_back
+ * Usage: cvec_push_front(v, &elem); cvec_pop_front(v, &elem)
+ * ----------------------------------------------------------
+ * These functions let a CVector serve as a double-ended queue. The
+ * storage is used as a ring buffer: element 0 need not be at the start
+ * of storage, and the elements may run off the end of storage and
+ * continue at its start. cvec_push_front prepends a copy of the element
+ * at addr, so the former element 0 becomes element 1; together with
+ * cvec_append it adds at either end. cvec_pop_front and cvec_pop_back
+ * remove the first or last element. If addr is not NULL, the removed
+ * element is copied to that location and ownership passes to the
+ * client, so the cleanup function is not called; if addr is NULL, the
+ * element is cleaned as by cvec_remove. Nothing is shifted, and indexing
+ * with cvec_nth stays constant-time. An assert is raised on popping an
+ * empty CVector or on allocation failure. Operate in constant-time
+ * (amortized).
+ *
+ * Asserts: empty CVector (pop), allocation failure (push)
+ * Assumes: address of valid elem
+ */
+void cvec_push_front(CVector *cv, const void *addr);
+void cvec_pop_front(CVector *cv, void *addr);
+void cvec_pop_back(CVector *cv, void *addr);
+
+
+/**
+ * Type: CVecSpan
+ * --------------
+ * A run of count elements stored contiguously, starting at data.
+ */
+typedef struct {
+    void *data;
+    int count;
+} CVecSpan;
+
+
+/**
+ * Function: cvec_span
+ * Usage: CVecSpan s[2]; int n = cvec_span(v, s)
+ * ---------------------------------------------
+ * Describes where the elements are stored without moving them. Fills in
+ * spans[0] and, if the elements wrap around the end of storage,
+ * spans[1], and returns the number of spans filled: 0 for an empty
+ * CVector, otherwise 1 or 2. Together the spans hold elements 0 to
+ * count-1 in order. This gives a bulk consumer (write, memcpy, a
+ * checksum) contiguous access even to a wrapped CVector. The pointers are
+ * subject to the same rules as one returned by cvec_nth.
+ * Operates in constant-time.
+ */
+int cvec_span(const CVector *cv, CVecSpan spans[2]);
+
+
+/**
+ * Function: cvec_linearize
+ * Usage: cvec_linearize(v)
+ * ------------------------
+ * Moves the elements so that they start at the beginning of storage,
+ * undoing any wrap-around left by cvec_push_front and cvec_pop_front.
+ * Element order and values are unchanged. Functions that need the
+ * elements in one block (cvec_data, cvec_sort, and inserting or
+ * removing in the middle) do this on their own when needed, so clients
+ * rarely call it. Operates in linear-time.
+ *
+ * Asserts: allocation failure
+ */
+void cvec_linearize(CVector *cv);
+
 /**
  * Function: cvec_search
  * Usage: int found = cvec_search(v, &key, cmp_students, 0, false)
@@ -190,16 +447,21 @@ void cvec_append(CVector *cv, const void *addr);
  * expected to be a valid pointer to the key element. For example, if
  * this CVector has been created for int elements, keyaddr should be
  * the memory location where the key int value is stored.
- * It uses the provided cmp callback to compare elements.
- * The search considers all elements from start index to end. 
- * To search the entire CVector, specify a start index of 0. 
+ * It uses the provided cmp callback to compare elements, always passing
+ * the key as the first argument and an element as the second (as
+ * bsearch does). The search considers all elements from start index to
+ * end. To search the entire CVector, specify a start index of 0.
  * The sorted parameter allows the client to specify that elements
  * are currently stored in sorted order, in which case cvec_search uses a
  * faster binary search. If sorted is false, linear search is used instead.
  * If a match is found, the index of a matching element is returned;
- * else -1 is returned. If more than one match exists, any of the
- * matching indexes can be returned. This function does not 
- * re-arrange/modify elements within the CVector or modify the key. 
+ * else -1 is returned. If more than one match exists, the lowest
+ * matching index is returned. To find where a missing key belongs, or
+ * every match, see cvec_lower_bound and cvec_equal_range. For many
+ * searches of one large sorted CVector, a CVecIndex (cvecindex.h) is
+ * faster.
+ * This function does not re-arrange/modify elements within the CVector
+ * or modify the key.
  * Operates in linear-time or logarithmic-time (if sorted).
  * 
  * An assert is raised if start is less than 0 or greater than the
@@ -213,6 +475,119 @@ void cvec_append(CVector *cv, const void *addr);
 int cvec_search(const CVector *cv, const void *keyaddr, CompareFn cmp, int start, bool sorted);
 
 
+/**
+ * Function: cvec_lower_bound
+ * Usage: int index = cvec_lower_bound(v, &key, cmp_int)
+ * -----------------------------------------------------
+ * Searches a CVector whose elements are sorted according to cmp and
+ * returns the index of the first element that does not sort before the
+ * key element at keyaddr: the first match if there is one, otherwise the
+ * index at which the key would be inserted to keep the order. Returns
+ * the count if every element sorts before the key. Operates in
+ * logarithmic-time.
+ *
+ * Assumes: CVector is sorted by cmp, address of valid key, cmp fn is valid
+ */
+int cvec_lower_bound(const CVector *cv, const void *keyaddr, CompareFn cmp);
+
+
+/**
+ * Function: cvec_upper_bound
+ * Usage: int index = cvec_upper_bound(v, &key, cmp_int)
+ * -----------------------------------------------------
+ * Like cvec_lower_bound, but returns the index of the first element that
+ * sorts after the key, that is, one past the last match. Returns the
+ * count if no element sorts after the key. Operates in logarithmic-time.
+ *
+ * Assumes: CVector is sorted by cmp, address of valid key, cmp fn is valid
+ */
+int cvec_upper_bound(const CVector *cv, const void *keyaddr, CompareFn cmp);
+
+
+/**
+ * Function: cvec_equal_range
+ * Usage: int n = cvec_equal_range(v, &key, cmp_int, &first, &last)
+ * ----------------------------------------------------------------
+ * Finds the run of elements matching the key element at keyaddr in a
+ * CVector sorted according to cmp. The index of the first match is
+ * stored at first and the index one past the last at last, and the number
+ * of matches (last - first) is returned. If there is no match, first and
+ * last both hold the index where the key would be inserted and 0 is
+ * returned. Either address may be NULL if that index is not wanted.
+ * Operates in logarithmic-time.
+ *
+ * Assumes: CVector is sorted by cmp, address of valid key, cmp fn is valid
+ */
+int cvec_equal_range(const CVector *cv, const void *keyaddr, CompareFn cmp, int *first, int *last);
+
+
+/**
+ * Function: cvec_insert_sorted
+ * Usage: int index = cvec_insert_sorted(v, &elem, cmp_int, false)
+ * ---------------------------------------------------------------
+ * Inserts a copy of the element at addr into a CVector sorted according
+ * to cmp, at the position that keeps it sorted, and returns the new
+ * element's index. The element goes after any elements it compares equal
+ * to, so elements with equal keys stay in insertion order. If unique is
+ * true and an equal element is already present, nothing is inserted and
+ * -1 is returned, so the CVector can serve as a compact ordered set.
+ * Finding the position takes logarithmic-time; the insertion itself
+ * shifts the elements after it (or, at the front, none), as cvec_insert
+ * does, so operates in linear-time overall. An assert is raised on
+ * allocation failure.
+ *
+ * Asserts: allocation failure
+ * Assumes: CVector is sorted by cmp, addr is valid, cmp fn is valid
+ */
+int cvec_insert_sorted(CVector *cv, const void *addr, CompareFn cmp, bool unique);
+
+
+/**
+ * Function: cvec_search_many
+ * Usage: cvec_search_many(v, keys, nkeys, cmp_int, found)
+ * -------------------------------------------------------
+ * Searches a CVector whose elements are sorted according to cmp for each
+ * of m key elements stored contiguously at keys, storing in found[i] the
+ * index of the first element matching key i, or -1 if there is none.
+ * Rather than m independent binary searches, the keys are taken in
+ * sorted order and matched in one forward pass over the CVector, each
+ * search galloping ahead from where the previous one ended. For keys
+ * that are dense relative to the CVector this reads memory nearly
+ * sequentially and costs O(m + n) compares; for sparse keys,
+ * O(m log(n/m)). If the keys are already sorted this is detected and
+ * they are used as given; otherwise the search sorts an internal copy
+ * of them, in mlogm-time, and the keys array itself is not modified. An
+ * assert is raised if m is negative or on allocation failure.
+ *
+ * Asserts: negative m, allocation failure
+ * Assumes: CVector is sorted by cmp, keys is a valid array of m elements,
+ * found has room for m ints
+ */
+void cvec_search_many(const CVector *cv, const void *keys, int m, CompareFn cmp, int *found);
+
+
+/**
+ * Function: cvec_find_eq
+ * Usage: int index = cvec_find_eq(v, &key, 0)
+ * -------------------------------------------
+ * Searches the CVector for an element whose bytes are identical to those
+ * of the element at keyaddr, starting at index start, and returns the
+ * index of the first one found or -1 if none is. Unlike cvec_search, no
+ * compare function is called: elements of 1, 2, 4 or 8 bytes are
+ * compared many at a time with vector instructions (on x86-64, AVX2 if
+ * the processor has it, otherwise SSE2), other sizes one at a time with
+ * memcmp. Because the comparison is bytewise, it suits integers, chars
+ * and pointers; for floating point +0.0 and -0.0 differ and a NaN
+ * matches an identical NaN, and structs must not have padding bytes
+ * of unknown value. An assert is raised if start is less than 0 or
+ * greater than the count. Operates in linear-time.
+ *
+ * Asserts: invalid start index
+ * Assumes: keyaddr points to a valid element
+ */
+int cvec_find_eq(const CVector *cv, const void *keyaddr, int start);
+
+
 /**
  * Function: cvec_sort
  * Usage: cvec_sort(v, cmp_student)
@@ -225,6 +600,179 @@ int cvec_search(const CVector *cv, const void *keyaddr, CompareFn cmp, int start
 void cvec_sort(CVector *cv, CompareFn cmp);
 
 
+/**
+ * Type: CVecKeyKind
+ * -----------------
+ * How cvec_sort_keyed interprets the bytes of a key.
+ *
+ *   CVEC_KEY_UNSIGNED  unsigned integer (uint8_t .. uint64_t)
+ *   CVEC_KEY_SIGNED    two's complement integer (int8_t .. int64_t)
+ *   CVEC_KEY_FLOAT     IEEE float (4 bytes) or double (8 bytes); -0.0
+ *                      sorts before +0.0, and NaNs sort beyond the
+ *                      infinities of the same sign
+ */
+typedef enum {
+    CVEC_KEY_UNSIGNED,
+    CVEC_KEY_SIGNED,
+    CVEC_KEY_FLOAT
+} CVecKeyKind;
+
+
+/**
+ * Function: cvec_sort_keyed
+ * Usage: cvec_sort_keyed(v, offsetof(Student, id), sizeof(int), CVEC_KEY_SIGNED)
+ * ------------------------------------------------------------------------------
+ * Rearranges elements into ascending order of a numeric key stored in
+ * each element, key_width bytes at key_offset bytes from the start of
+ * the element, interpreted according to kind. For keys of 1, 2, 4 or 8
+ * bytes, instead of calling a comparison function, it runs a radix sort
+ * over the key's bits, 11 at a time, which makes at most 6 passes over
+ * the elements for an 8-byte key (3 for 4 bytes; fewer when some digit
+ * is the same in every key), so large vectors sort several times faster
+ * than with cvec_sort. Integer keys of other widths (stored in the
+ * machine's byte order) are sorted with qsort instead, in NlgN-time.
+ * Float keys must be 4 or 8 bytes. The sort is stable: elements with
+ * equal keys keep their relative order. It needs temporary storage as
+ * large as the CVector's elements. An assert is raised for a float key
+ * of another width, a zero width or a key that does not lie within the
+ * element, or on allocation failure. Operates in linear-time.
+ *
+ * Asserts: invalid key width/offset, allocation failure
+ */
+void cvec_sort_keyed(CVector *cv, size_t key_offset, size_t key_width, CVecKeyKind kind);
+
+
+/**
+ * Function: cvec_nth_element
+ * Usage: cvec_nth_element(v, cvec_count(v) / 2, cmp_int)
+ * ------------------------------------------------------
+ * Partially rearranges the CVector according to the client's cmp
+ * callback so that the element at index n is the one that would be there
+ * if the whole CVector were sorted, no element before it sorts after it,
+ * and no element after it sorts before it. The elements on either side
+ * are otherwise in no particular order. Uses introselect: quickselect
+ * with median-of-3 pivots, sorting the remaining range if partitioning
+ * keeps going badly. An assert is raised if n is out of bounds. Operates
+ * in linear-time on average, NlgN-time at worst.
+ *
+ * Asserts: invalid index
+ * Assumes: cmp fn is valid
+ */
+void cvec_nth_element(CVector *cv, int n, CompareFn cmp);
+
+
+/**
+ * Function: cvec_partial_sort
+ * Usage: cvec_partial_sort(v, 100, cmp_score)
+ * -------------------------------------------
+ * Rearranges the CVector so that indexes 0 to k-1 hold its k least
+ * elements according to the client's cmp callback, in ascending order;
+ * the remaining elements follow in no particular order. Equivalent to
+ * cvec_sort when k is the count, but when only the first few elements
+ * are needed it is much faster: the k elements are selected as by
+ * cvec_nth_element and only they are sorted. An assert is raised if k
+ * is less than 0 or greater than the count. Operates in N + klgk-time
+ * on average.
+ *
+ * Asserts: invalid k
+ * Assumes: cmp fn is valid
+ */
+void cvec_partial_sort(CVector *cv, int k, CompareFn cmp);
+
+
+/**
+ * Functions: cvec_heapify, cvec_heap_push, cvec_heap_pop
+ * Usage: cvec_heap_push(queue, &task, cmp_priority)
+ * -------------------------------------------------
+ * These functions use the CVector as a priority queue: a binary max-heap
+ * ordered by the client's cmp callback, kept in the CVector's own
+ * storage. The greatest element is always at index 0, where cvec_nth
+ * reads it in constant-time. cvec_heapify arranges any CVector as a heap,
+ * in linear-time. cvec_heap_push adds a copy of the element at addr, and
+ * cvec_heap_pop removes the greatest element, copying it to addr, or, if
+ * addr is NULL, passing it to the cleanup function as cvec_pop_back
+ * does. Push and pop operate in logarithmic-time. For a min-heap, pass a
+ * cmp that orders in descending order. The client must not otherwise
+ * rearrange the elements between calls, and must pass the same cmp to
+ * each. An assert is raised on popping an empty CVector or on
+ * allocation failure.
+ *
+ * Asserts: empty CVector, allocation failure
+ * Assumes: CVector is a heap ordered by cmp (except for cvec_heapify), cmp fn is valid
+ */
+void cvec_heapify(CVector *cv, CompareFn cmp);
+void cvec_heap_push(CVector *cv, const void *addr, CompareFn cmp);
+void cvec_heap_pop(CVector *cv, void *addr, CompareFn cmp);
+
+
+/**
+ * Functions: cvec_heapify4, cvec_heap4_push, cvec_heap4_pop
+ * Usage: cvec_heap4_pop(queue, &task, cmp_priority)
+ * -------------------------------------------------
+ * The same operations on a 4-ary heap, in which each element has four
+ * children rather than two. The tree is half as deep, so a pop moves the
+ * sinking element through half as many levels, each choosing among four
+ * adjacent children, which for small elements lie in the same cache
+ * line. For large queues of small elements this makes pops faster;
+ * pushes, which compare only with the parent, also get cheaper. The two
+ * layouts differ, so a CVector must be used with one set of functions
+ * only.
+ *
+ * Asserts: empty CVector, allocation failure
+ * Assumes: CVector is a 4-ary heap ordered by cmp (except for cvec_heapify4), cmp fn is valid
+ */
+void cvec_heapify4(CVector *cv, CompareFn cmp);
+void cvec_heap4_push(CVector *cv, const void *addr, CompareFn cmp);
+void cvec_heap4_pop(CVector *cv, void *addr, CompareFn cmp);
+
+
+/**
+ * Function: cvec_topk_add
+ * Usage: cvec_topk_add(top, 100, &score, cmp_score_desc)
+ * ------------------------------------------------------
+ * Selects the k least elements, according to the client's cmp callback,
+ * from a stream of elements offered one at a time, such as results as
+ * they are computed, without storing the stream. top is a CVector the
+ * client creates empty and passes with the same k and cmp on every call;
+ * it keeps at most k elements, arranged as a binary max-heap (see
+ * cvec_heap_push) with the greatest at index 0. The element at addr is
+ * copied in if top holds fewer than k elements or if it sorts before the
+ * greatest, which is then replaced (calling top's cleanup function on
+ * it, as cvec_replace does). Returns true if the element was copied in;
+ * if false, top is unchanged and the client still owns the element. To
+ * keep the k greatest instead, as for the highest scores, pass a cmp
+ * that orders in descending order. When the stream ends, cvec_sort puts
+ * top in order. An assert is raised if k is negative or less than top's
+ * count, or on allocation failure. Operates in lgk-time.
+ *
+ * Asserts: invalid k, allocation failure
+ * Assumes: top holds only elements added by cvec_topk_add with this k and
+ * cmp, addr is valid, cmp fn is valid
+ */
+bool cvec_topk_add(CVector *top, int k, const void *addr, CompareFn cmp);
+
+
+/**
+ * Function: cvec_topk
+ * Usage: CVector *best = cvec_topk(v, 100, cmp_score_desc)
+ * --------------------------------------------------------
+ * Returns a new CVector holding copies of the k least elements of the
+ * CVector according to the client's cmp callback, in ascending order
+ * (or all of its elements, if it has fewer than k). The CVector itself
+ * is not modified. Elements are offered one at a time to cvec_topk_add,
+ * so only k elements are held in extra memory. The new CVector has no
+ * cleanup function, since its elements are shallow copies of elements
+ * still owned by the original; the client must call cvec_dispose on it
+ * when done. An assert is raised if k is negative or on allocation
+ * failure. Operates in Nlgk-time at worst, and close to linear-time
+ * when k is small, since most elements are rejected by one compare.
+ *
+ * Asserts: invalid k, allocation failure
+ * Assumes: cmp fn is valid
+ */
+CVector *cvec_topk(const CVector *cv, int k, CompareFn cmp);
+
+
 /**
  * Functions: cvec_first, cvec_next
  * Usage: for (void *cur = cvec_first(v); cur != NULL; cur = cvec_next(v, cur))
@@ -0,0 +1,114 @@
+/* File: cvector_inline.h
+ * ----------------------
+ * Exposes the CVector representation for inlined access in hot loops.
+ *
+ * The functions in cvector.h are compiled separately from the client, so
+ * even trivial ones such as cvec_count and cvec_next cost a real call at
+ * every step of a client loop, and the compiler cannot vectorize across
+ * them. A client that needs the last bit of speed can opt in by including
+ * this header, which completes the CVector struct and provides static
+ * inline versions of the simple accessors. They behave exactly like the
+ * functions of the same name without the _inline suffix.
+ *
+ * The price is that client code compiled with this header depends on the
+ * field layout, so it must be recompiled whenever cvector.c changes. The
+ * fields are visible only so the accessors can be inlined; clients must
+ * not read or write them directly.
+ *
+ * Example:
+ *
+ *     int *nums = cvec_data_inline(cv);
+ *     for (int i = 0; i < cvec_count_inline(cv); i++)
+ *         sum += nums[i];
+ */
+
+#ifndef _cvector_inline_h
+#define _cvector_inline_h
+
+#include "cvector.h"
+#include <assert.h>
+#include <stddef.h>
+
+/* Type: CVecStorage
+ * -----------------
+ * Where a CVector's element storage comes from. Small vectors start with
+ * their elements inline, in the same allocation as the struct, and spill
+ * to the heap when they outgrow it; very large storage is mapped directly
+ * (see cvec_resize in cvector.c).
+ */
+typedef enum {
+    CVEC_STORE_HEAP,
+    CVEC_STORE_INLINE,
+    CVEC_STORE_MAPPED
+} CVecStorage;
+
+/* Type: CVecMaxAlign
+ * ------------------
+ * A type whose alignment suits any element a client stores, standing in
+ * for C11's max_align_t so that the library builds as C99.
+ */
+typedef union {
+    long double ld;
+    long long ll;
+    double d;
+    void *p;
+    void (*fn)(void);
+} CVecMaxAlign;
+
+/* Type: struct CVectorImplementation
+ * ----------------------------------
+ * This definition completes the CVector type that was declared in
+ * cvector.h. It is shared by cvector.c and the inline accessors below.
+ */
+struct CVectorImplementation {
+    void *data; // pointer to contiguous memory where data is in heap
+    size_t size; // number of elements in CVector
+    size_t capacity; // number of elements possible with current allocated memory
+    size_t head; // slot holding element 0; elements wrap around at capacity
+    size_t elemsz; // number of bytes required by each element
+    CleanupElemFn clean; // cleanup function
+    CVecGrowth growth; // how capacity is enlarged when full
+    size_t chunk; // elements added per step for CVEC_GROW_CHUNK
+    CVecStorage storage; // how data was allocated
+    size_t mapsz; // bytes mapped, a multiple of the page size
+    size_t inline_cap; // elements that fit in inline_buf, 0 if none
+    CVecMaxAlign inline_buf[]; // inline element storage, sized at creation
+};
+
+
+/* Functions: cvec_count_inline, cvec_nth_inline, cvec_data_inline,
+ *            cvec_first_inline, cvec_next_inline
+ * ----------------------------------------------------------------
+ * Inline equivalents of cvec_count, cvec_nth, cvec_data, cvec_first and
+ * cvec_next; see cvector.h for their behavior.
+ */
+static inline int cvec_count_inline(const CVector *cv) {
+    return cv->size;
+}
+
+static inline void *cvec_nth_inline(const CVector *cv, int index) {
+    // index out of bounds check
+    assert(index >= 0 && index < (int)cv->size);
+    size_t slot = cv->head + index;
+    if(slot >= cv->capacity) slot -= cv->capacity;
+    return (char *)cv->data + slot * cv->elemsz;
+}
+
+static inline void *cvec_data_inline(CVector *cv) {
+    // a wrapped ring has to be unwrapped out of line first
+    if(cv->head + cv->size > cv->capacity) return cvec_data(cv);
+    return (char *)cv->data + cv->head * cv->elemsz;
+}
+
+static inline void *cvec_first_inline(const CVector *cv) {
+    return (cv->size == 0) ? NULL : (char *)cv->data + cv->head * cv->elemsz;
+}
+
+static inline void *cvec_next_inline(const CVector *cv, const void *prev) {
+    // the last element ends the iteration
+    if(prev == cvec_nth_inline(cv, cv->size - 1)) return NULL;
+    char *next = (char *)prev + cv->elemsz;
+    return (next == (char *)cv->data + cv->capacity * cv->elemsz) ? cv->data : next;
+}
+
+#endif
@@ -0,0 +1,534 @@
+/*
+ * File: cvector_parallel.c
+ * ------------------------
+ * Implementation of multithreaded CVector operations with POSIX threads.
+ */
+
+#define _GNU_SOURCE // for pthread_barrier_t
+#include "cvector_parallel.h"
+#include "cvector_inline.h" // completes struct CVectorImplementation
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// fewer elements than this per thread are not worth a thread
+#define MIN_PER_THREAD 16384
+
+// cache line size, to keep each participant's range on its own line
+#define LINE 64
+
+// with grain 0, each participant's share is cut into about this many chunks
+#define CHUNKS_PER_THREAD 16
+
+/* Type: SortShared
+ * ----------------
+ * State shared by the threads of one cvec_sort_parallel. bounds[0..nruns]
+ * are the element offsets of the sorted runs; runs are merged from src
+ * into dst each round, then the buffers swap.
+ */
+typedef struct {
+    char *src, *dst;
+    size_t elemsz;
+    CompareFn cmp;
+    int nthreads;
+    size_t *bounds;
+    int nruns;
+    pthread_barrier_t barrier;
+} SortShared;
+
+typedef struct {
+    SortShared *sh;
+    int id;
+} SortWorker;
+
+
+/* Function: corank
+ * ----------------
+ * Purpose: Finds how many of the first k elements of the merge of runs
+ * a and b come from a, taking from a first on ties, by binary search.
+ * Lets a merge be split among threads at any output position.
+ * Parameters: run a and its length, run b and its length, output
+ * position k, element size, compare callback function
+ * Return values: number of elements taken from a
+ */
+static size_t corank(const char *a, size_t na, const char *b, size_t nb, size_t k,
+                     size_t elemsz, CompareFn cmp) {
+    size_t lo = (k > nb) ? k - nb : 0;
+    size_t hi = (k < na) ? k : na;
+    while(lo < hi) {
+        size_t i = lo + (hi - lo) / 2, j = k - i;
+        // a[i] belongs in the first k if it does not sort after b[j-1]
+        if(cmp(a + i*elemsz, b + (j-1)*elemsz) <= 0) lo = i + 1;
+        else hi = i;
+    }
+    return lo;
+}
+
+/* Function: merge
+ * ---------------
+ * Purpose: Merges two sorted runs into out, taking from a first on ties
+ * Parameters: run a and its length, run b and its length, output array,
+ * element size, compare callback function
+ * Return values: void
+ */
+static void merge(const char *a, size_t na, const char *b, size_t nb, char *out,
+                  size_t elemsz, CompareFn cmp) {
+    const char *aend = a + na*elemsz, *bend = b + nb*elemsz;
+    while(a < aend && b < bend) {
+        if(cmp(b, a) < 0) {
+            memcpy(out, b, elemsz);
+            b += elemsz;
+        } else {
+            memcpy(out, a, elemsz);
+            a += elemsz;
+        }
+        out += elemsz;
+    }
+    memcpy(out, a, aend - a);
+    memcpy(out + (aend - a), b, bend - b);
+}
+
+/* Function: merge_round
+ * ---------------------
+ * Purpose: Does one thread's share of a merge round. Each pair of runs
+ * gets an equal group of threads (leftover threads idle) and each thread
+ * in the group produces an equal slice of the pair's output.
+ * Parameters: shared sort state, thread number
+ * Return values: void
+ */
+static void merge_round(SortShared *sh, int id) {
+    int npairs = (sh->nruns + 1) / 2;
+    int per_pair = sh->nthreads / npairs;
+    int pair = id / per_pair, part = id % per_pair;
+    if(pair >= npairs) return;
+
+    size_t start = sh->bounds[2*pair];
+    size_t mid = sh->bounds[2*pair + 1];
+    size_t end = (2*pair + 2 <= sh->nruns) ? sh->bounds[2*pair + 2] : mid; // odd run out: b is empty
+    const char *a = sh->src + start*sh->elemsz, *b = sh->src + mid*sh->elemsz;
+    size_t na = mid - start, nb = end - mid;
+
+    size_t lo = (na + nb) * part / per_pair;
+    size_t hi = (na + nb) * (part + 1) / per_pair;
+    size_t ilo = corank(a, na, b, nb, lo, sh->elemsz, sh->cmp);
+    size_t ihi = corank(a, na, b, nb, hi, sh->elemsz, sh->cmp);
+    merge(a + ilo*sh->elemsz, ihi - ilo, b + (lo - ilo)*sh->elemsz, (hi - ihi) - (lo - ilo),
+          sh->dst + (start + lo)*sh->elemsz, sh->elemsz, sh->cmp);
+}
+
+/* Function: sort_worker
+ * ---------------------
+ * Purpose: Thread body: sorts this thread's run, then takes part in every
+ * merge round. All threads meet at a barrier between rounds; thread 0
+ * alone updates the shared run list while the others wait.
+ * Parameters: pointer to SortWorker
+ * Return values: NULL
+ */
+static void *sort_worker(void *arg) {
+    SortWorker *w = arg;
+    SortShared *sh = w->sh;
+    size_t start = sh->bounds[w->id];
+    qsort(sh->src + start*sh->elemsz, sh->bounds[w->id + 1] - start, sh->elemsz, sh->cmp);
+
+    while(sh->nruns > 1) {
+        pthread_barrier_wait(&sh->barrier); // runs are sorted
+        merge_round(sh, w->id);
+        if(pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            // one thread halves the run list and swaps buffers
+            int nruns = (sh->nruns + 1) / 2;
+            for(int r = 0; r <= nruns; r++) {
+                int old = 2*r;
+                sh->bounds[r] = sh->bounds[(old < sh->nruns) ? old : sh->nruns];
+            }
+            sh->nruns = nruns;
+            char *tmp = sh->src;
+            sh->src = sh->dst;
+            sh->dst = tmp;
+        }
+        pthread_barrier_wait(&sh->barrier); // run list is updated
+    }
+    return NULL;
+}
+
+/* Function: cvec_sort_parallel
+ * ----------------------------
+ * Purpose: Sorts one run per thread, then merges the runs in parallel
+ * Parameters: pointer to CVector, callback compare function, number of
+ * threads (0 for one per processor)
+ * Return values: void
+ */
+void cvec_sort_parallel(CVector *cv, CompareFn cmp, int nthreads) {
+    if(nthreads <= 0) nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nthreads > cvec_count(cv) / MIN_PER_THREAD) nthreads = cvec_count(cv) / MIN_PER_THREAD;
+    if(nthreads <= 1) {
+        cvec_sort(cv, cmp);
+        return;
+    }
+
+    size_t n = cvec_count(cv);
+    SortShared sh;
+    sh.src = cvec_data(cv); // one contiguous block
+    sh.dst = malloc(n * cv->elemsz);
+    assert(sh.dst != NULL);
+    sh.elemsz = cv->elemsz;
+    sh.cmp = cmp;
+    sh.nthreads = nthreads;
+    sh.nruns = nthreads;
+    sh.bounds = malloc((nthreads + 1) * sizeof(size_t));
+    assert(sh.bounds != NULL);
+    for(int t = 0; t <= nthreads; t++) sh.bounds[t] = n * t / nthreads;
+    pthread_barrier_init(&sh.barrier, NULL, nthreads);
+
+    char *orig = sh.src, *scratch = sh.dst;
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    SortWorker *workers = malloc(nthreads * sizeof(SortWorker));
+    assert(threads != NULL && workers != NULL);
+    for(int t = 1; t < nthreads; t++) {
+        workers[t] = (SortWorker){ &sh, t };
+        int err = pthread_create(&threads[t], NULL, sort_worker, &workers[t]);
+        assert(err == 0);
+    }
+    // the calling thread is worker 0
+    workers[0] = (SortWorker){ &sh, 0 };
+    sort_worker(&workers[0]);
+    for(int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+    // an odd number of rounds leaves the result in scratch
+    if(sh.src != orig) memcpy(orig, sh.src, n * cv->elemsz);
+    pthread_barrier_destroy(&sh.barrier);
+    free(scratch);
+    free(sh.bounds);
+    free(threads);
+    free(workers);
+}
+
+/* Function: line_alloc
+ * ---------------------
+ * Purpose: Allocates memory that starts on a cache line
+ * Parameters: number of bytes
+ * Return values: pointer to memory, to be released with free
+ */
+static void *line_alloc(size_t nbytes) {
+    void *mem;
+    if(posix_memalign(&mem, LINE, nbytes) != 0) mem = NULL;
+    // assert if allocation fails
+    assert(mem != NULL);
+    return mem;
+}
+
+/* Type: Slot
+ * ----------
+ * The part of a job's range one participant has yet to take, next..end-1.
+ * The owner takes chunks from the front; a thief takes the back half.
+ * Padded to a multiple of LINE and allocated line-aligned, so that
+ * participants do not share cache lines.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next, end;
+    char pad[LINE - (sizeof(pthread_mutex_t) + 2 * sizeof(size_t)) % LINE];
+} Slot;
+
+/* Type: Job
+ * ---------
+ * One parallel loop: body is called on chunks of 0..n-1 by nworkers
+ * participants, the caller being participant 0.
+ */
+typedef struct {
+    void (*body)(void *arg, size_t begin, size_t end, int worker);
+    void *arg;
+    size_t grain;
+    int nworkers;
+    Slot *slots;
+} Job;
+
+/* Type: pool
+ * ----------
+ * The threads shared by every cvec_parallel_for and cvec_parallel_reduce.
+ * They are started on first use, as many as needed, and then wait for
+ * jobs for the life of the process. Jobs run one at a time.
+ */
+static struct {
+    pthread_mutex_t serial; // held by the caller for the whole of a job
+    pthread_mutex_t lock; // guards the fields below
+    pthread_cond_t wake; // a job was posted
+    pthread_cond_t done; // the last pool thread finished the job
+    Job *job;
+    unsigned long generation; // number of jobs posted
+    int nthreads; // pool threads started, not counting callers
+    int busy; // pool threads not yet done with the current job
+    int want; // participants per job, 0 for one per processor
+} pool = { .serial = PTHREAD_MUTEX_INITIALIZER, .lock = PTHREAD_MUTEX_INITIALIZER,
+           .wake = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER };
+
+// set in pool threads and in a caller running a job, so nested loops run serially
+static __thread int in_job;
+
+typedef struct {
+    int id;
+    unsigned long seen; // generation when started
+} PoolStart;
+
+
+/* Function: take_chunk
+ * --------------------
+ * Purpose: Takes up to grain elements from the front of a participant's
+ * own range
+ * Parameters: job, participant number, addresses for the chunk's bounds
+ * Return values: true if a chunk was taken, false if the range is empty
+ */
+static bool take_chunk(Job *job, int id, size_t *begin, size_t *end) {
+    Slot *s = &job->slots[id];
+    pthread_mutex_lock(&s->lock);
+    bool got = s->next < s->end;
+    if(got) {
+        *begin = s->next;
+        *end = (s->end - s->next > job->grain) ? s->next + job->grain : s->end;
+        s->next = *end;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return got;
+}
+
+/* Function: steal
+ * ---------------
+ * Purpose: Moves the back half of another participant's remaining range
+ * into this participant's own, trying the others in turn. Taking half
+ * rather than a chunk means a thief rarely needs to steal again, and the
+ * range stays contiguous for both.
+ * Parameters: job, participant number
+ * Return values: true if work was stolen, false if every range is empty
+ */
+static bool steal(Job *job, int id) {
+    for(int i = 1; i < job->nworkers; i++) {
+        Slot *victim = &job->slots[(id + i) % job->nworkers];
+        pthread_mutex_lock(&victim->lock);
+        size_t left = victim->end - victim->next;
+        size_t mid = victim->end - (left + 1) / 2, end = victim->end;
+        victim->end = mid;
+        pthread_mutex_unlock(&victim->lock);
+        if(left == 0) continue;
+
+        Slot *s = &job->slots[id];
+        pthread_mutex_lock(&s->lock);
+        s->next = mid;
+        s->end = end;
+        pthread_mutex_unlock(&s->lock);
+        return true;
+    }
+    return false;
+}
+
+/* Function: work
+ * --------------
+ * Purpose: Runs chunks of a job from this participant's range, then from
+ * others', until no range has any left
+ * Parameters: job, participant number
+ * Return values: void
+ */
+static void work(Job *job, int id) {
+    size_t begin, end;
+    for(;;) {
+        if(take_chunk(job, id, &begin, &end)) job->body(job->arg, begin, end, id);
+        else if(!steal(job, id)) return;
+    }
+}
+
+/* Function: pool_thread
+ * ---------------------
+ * Purpose: Thread body of a pool thread: waits for each job, works on it
+ * if the job has a place for this thread, and reports when done
+ * Parameters: pointer to malloc'ed PoolStart
+ * Return values: never returns
+ */
+static void *pool_thread(void *arg) {
+    PoolStart start = *(PoolStart *)arg;
+    free(arg);
+    in_job = 1;
+    unsigned long seen = start.seen;
+    pthread_mutex_lock(&pool.lock);
+    for(;;) {
+        while(pool.generation == seen) pthread_cond_wait(&pool.wake, &pool.lock);
+        seen = pool.generation;
+        Job *job = pool.job;
+        pthread_mutex_unlock(&pool.lock);
+        if(start.id < job->nworkers) work(job, start.id);
+        pthread_mutex_lock(&pool.lock);
+        if(--pool.busy == 0) pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+/* Function: participants
+ * ----------------------
+ * Purpose: Decides how many participants a loop over n elements gets,
+ * and the grain if the client left it to us
+ * Parameters: number of elements, address of grain (0 for automatic)
+ * Return values: number of participants, 1 to run on the caller alone
+ */
+static int participants(size_t n, size_t *grain) {
+    pthread_mutex_lock(&pool.lock);
+    int want = pool.want;
+    pthread_mutex_unlock(&pool.lock);
+    if(want <= 0) want = sysconf(_SC_NPROCESSORS_ONLN);
+    if(in_job || want < 1) want = 1;
+    if(*grain == 0) *grain = n / ((size_t)want * CHUNKS_PER_THREAD) + 1;
+    size_t chunks = (n + *grain - 1) / *grain;
+    return (chunks < (size_t)want) ? (chunks > 0 ? chunks : 1) : want;
+}
+
+/* Function: run_job
+ * -----------------
+ * Purpose: Splits 0..n-1 evenly among the participants, starts any pool
+ * threads still needed, posts the job, works on it as participant 0 and
+ * waits for the pool threads to finish
+ * Parameters: job with body, arg, grain and nworkers set, number of elements
+ * Return values: void
+ */
+static void run_job(Job *job, size_t n) {
+    if(job->nworkers <= 1) {
+        if(n > 0) job->body(job->arg, 0, n, 0);
+        return;
+    }
+    job->slots = line_alloc(job->nworkers * sizeof(Slot));
+    for(int w = 0; w < job->nworkers; w++) {
+        pthread_mutex_init(&job->slots[w].lock, NULL);
+        job->slots[w].next = n * w / job->nworkers;
+        job->slots[w].end = n * (w + 1) / job->nworkers;
+    }
+
+    pthread_mutex_lock(&pool.serial);
+    pthread_mutex_lock(&pool.lock);
+    while(pool.nthreads < job->nworkers - 1) {
+        PoolStart *start = malloc(sizeof(PoolStart));
+        assert(start != NULL);
+        *start = (PoolStart){ pool.nthreads + 1, pool.generation };
+        pthread_t thread;
+        int err = pthread_create(&thread, NULL, pool_thread, start);
+        assert(err == 0);
+        pthread_detach(thread);
+        pool.nthreads++;
+    }
+    pool.job = job;
+    pool.busy = pool.nthreads;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    in_job = 1;
+    work(job, 0);
+    in_job = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while(pool.busy > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.serial);
+
+    for(int w = 0; w < job->nworkers; w++) pthread_mutex_destroy(&job->slots[w].lock);
+    free(job->slots);
+}
+
+/* Function: cvec_parallel_set_threads
+ * -----------------------------------
+ * Purpose: Sets how many threads later parallel loops use
+ * Parameters: number of threads (0 for one per processor)
+ * Return values: void
+ */
+void cvec_parallel_set_threads(int nthreads) {
+    assert(nthreads >= 0);
+    pthread_mutex_lock(&pool.lock);
+    pool.want = nthreads;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* Function: run_end
+ * -----------------
+ * Purpose: Finds where the elements from begin stop being contiguous:
+ * at end, or earlier where the ring wraps around storage
+ * Parameters: pointer to CVector, first index, index past the last
+ * Return values: index past the contiguous run
+ */
+static size_t run_end(const CVector *cv, size_t begin, size_t end) {
+    size_t wrap = cv->capacity - cv->head; // index of the element in slot 0
+    return (begin < wrap && end > wrap) ? wrap : end;
+}
+
+typedef struct {
+    CVector *cv;
+    ChunkFn fn;
+    void *ctx;
+} ForJob;
+
+static void for_body(void *arg, size_t begin, size_t end, int worker) {
+    ForJob *fj = arg;
+    while(begin < end) {
+        size_t stop = run_end(fj->cv, begin, end);
+        fj->fn(cvec_nth_inline(fj->cv, begin), stop - begin, begin, fj->ctx);
+        begin = stop;
+    }
+}
+
+/* Function: cvec_parallel_for
+ * ---------------------------
+ * Purpose: Calls fn on contiguous chunks of the vector from the pool
+ * Parameters: pointer to CVector, chunk callback function, client
+ * context, chunk size (0 for automatic)
+ * Return values: void
+ */
+void cvec_parallel_for(CVector *cv, ChunkFn fn, void *ctx, int grain) {
+    assert(grain >= 0);
+    ForJob fj = { cv, fn, ctx };
+    Job job = { .body = for_body, .arg = &fj, .grain = grain };
+    job.nworkers = participants(cvec_count(cv), &job.grain);
+    run_job(&job, cvec_count(cv));
+}
+
+typedef struct {
+    const CVector *cv;
+    FoldFn fold;
+    void *ctx;
+    char *accs; // one accumulator per participant
+    size_t stride;
+} ReduceJob;
+
+static void reduce_body(void *arg, size_t begin, size_t end, int worker) {
+    ReduceJob *rj = arg;
+    while(begin < end) {
+        size_t stop = run_end(rj->cv, begin, end);
+        rj->fold(rj->accs + worker*rj->stride, cvec_nth_inline(rj->cv, begin), stop - begin, rj->ctx);
+        begin = stop;
+    }
+}
+
+/* Function: cvec_parallel_reduce
+ * ------------------------------
+ * Purpose: Folds chunks of the vector into one accumulator per
+ * participant, each starting as a copy of result, then combines them
+ * into result in participant order
+ * Parameters: pointer to CVector, fold callback, combine callback, client
+ * context, chunk size (0 for automatic), address and size of result
+ * Return values: void
+ */
+void cvec_parallel_reduce(const CVector *cv, FoldFn fold, CombineFn combine, void *ctx,
+                          int grain, void *result, size_t resultsz) {
+    assert(grain >= 0 && resultsz > 0);
+    ReduceJob rj = { .cv = cv, .fold = fold, .ctx = ctx };
+    Job job = { .body = reduce_body, .arg = &rj, .grain = grain };
+    job.nworkers = participants(cvec_count(cv), &job.grain);
+    if(job.nworkers <= 1) {
+        // fold straight into result
+        rj.accs = result;
+        run_job(&job, cvec_count(cv));
+        return;
+    }
+
+    rj.stride = (resultsz + LINE - 1) / LINE * LINE;
+    rj.accs = line_alloc(job.nworkers * rj.stride);
+    for(int w = 0; w < job.nworkers; w++) memcpy(rj.accs + w*rj.stride, result, resultsz);
+    run_job(&job, cvec_count(cv));
+    for(int w = 0; w < job.nworkers; w++) combine(result, rj.accs + w*rj.stride, ctx);
+    free(rj.accs);
+}
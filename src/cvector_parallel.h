@@ -0,0 +1,139 @@
+/* File: cvector_parallel.h
+ * ------------------------
+ * Defines multithreaded operations on the CVector.
+ *
+ * The functions in cvector.h run on the calling thread. For very large
+ * vectors, the functions here split the work among several threads. They
+ * are kept in a separate module so that programs that do not use them
+ * need not link with the threads library. Programs that do must be built
+ * with -pthread.
+ *
+ * While one of these functions runs, no other thread may use the CVector.
+ * The client's callbacks are called from several threads at once and so
+ * must be safe to call concurrently; a comparison function that only
+ * reads its two arguments is.
+ *
+ * cvec_parallel_for and cvec_parallel_reduce run on a pool of threads
+ * that is started the first time one of them needs it and then kept,
+ * waiting, for the life of the program, so that a loop costs no thread
+ * creation. The pool runs one loop at a time; a loop started from
+ * inside another loop's callback runs on the calling thread alone.
+ */
+
+#ifndef _cvector_parallel_h
+#define _cvector_parallel_h
+
+#include "cvector.h"
+
+
+/**
+ * Function: cvec_sort_parallel
+ * Usage: cvec_sort_parallel(v, cmp_student, 0)
+ * --------------------------------------------
+ * Rearranges elements in the CVector into ascending order according to
+ * the client's cmp callback, like cvec_sort, using up to nthreads
+ * threads. If nthreads is 0, one thread per online processor is used.
+ * The vector is cut into one run per thread and each thread sorts its
+ * run; then runs are merged in pairs, round after round, with every
+ * round split evenly among all the threads, so all threads stay busy
+ * until the last merge. Like cvec_sort, the sort is not stable. Vectors
+ * too small to benefit are sorted with cvec_sort on the calling thread.
+ * Needs temporary storage as large as the CVector's elements. An assert
+ * is raised on allocation failure or if a thread cannot be created.
+ * Operates in NlgN/nthreads-time plus N-time per merge round.
+ *
+ * Asserts: allocation failure, thread creation failure
+ * Assumes: cmp fn is valid and safe to call from several threads
+ */
+void cvec_sort_parallel(CVector *cv, CompareFn cmp, int nthreads);
+
+
+/**
+ * Type: ChunkFn
+ * -------------
+ * ChunkFn is the type of the callback cvec_parallel_for calls on each
+ * chunk of elements. elems points to the first of n elements stored
+ * contiguously, which are at indexes index to index+n-1 of the CVector.
+ * The callback may read and modify those elements (and no others), and
+ * should not add or remove elements.
+ */
+typedef void (*ChunkFn)(void *elems, int n, int index, void *ctx);
+
+
+/**
+ * Types: FoldFn, CombineFn
+ * ------------------------
+ * The callbacks of cvec_parallel_reduce. A FoldFn folds n elements
+ * stored contiguously at elems into the accumulator at acc, for example
+ * by adding them to a running sum. A CombineFn folds the accumulator at
+ * other into the one at acc.
+ */
+typedef void (*FoldFn)(void *acc, const void *elems, int n, void *ctx);
+typedef void (*CombineFn)(void *acc, const void *other, void *ctx);
+
+
+/**
+ * Function: cvec_parallel_set_threads
+ * Usage: cvec_parallel_set_threads(4)
+ * -----------------------------------
+ * Sets how many threads, counting the caller, later calls to
+ * cvec_parallel_for and cvec_parallel_reduce use. The default, and the
+ * value 0, is one per online processor. Pool threads already started are
+ * kept but left idle if no longer needed. An assert is raised if
+ * nthreads is negative.
+ *
+ * Asserts: negative nthreads
+ */
+void cvec_parallel_set_threads(int nthreads);
+
+
+/**
+ * Function: cvec_parallel_for
+ * Usage: cvec_parallel_for(v, scale_chunk, &factor, 0)
+ * ----------------------------------------------------
+ * Calls fn on every element of the CVector, a chunk at a time, using the
+ * pool threads and the calling thread, and returns when every chunk is
+ * done. The client's ctx is passed to every call. Each thread starts
+ * with an equal share of the elements and takes chunks of grain elements
+ * from the front of its share; a thread that runs out steals the back
+ * half of another's remaining share, so threads stay busy when some
+ * chunks take longer than others. A larger grain means fewer callbacks
+ * and less locking; a smaller grain, finer balancing. If grain is 0, a
+ * grain giving each thread several chunks is used. Chunks never span the
+ * point where a wrapped CVector's storage wraps around, so a chunk may
+ * be shorter than grain. Chunks run in no particular order. Small
+ * vectors run on the calling thread. An assert is raised if grain is
+ * negative, or on allocation or thread creation failure.
+ * Operates in N/nthreads-time.
+ *
+ * Asserts: negative grain, allocation failure, thread creation failure
+ * Assumes: fn is valid and safe to call from several threads
+ */
+void cvec_parallel_for(CVector *cv, ChunkFn fn, void *ctx, int grain);
+
+
+/**
+ * Function: cvec_parallel_reduce
+ * Usage: cvec_parallel_reduce(v, sum_chunk, add_sums, NULL, 0, &total, sizeof(total))
+ * -----------------------------------------------------------------------------------
+ * Reduces the CVector to one value, such as a sum or maximum, using the
+ * pool threads and the calling thread. On entry, result (resultsz bytes)
+ * must hold the identity value of the reduction, such as 0 for a sum.
+ * Each thread gets its own accumulator, a copy of result, and folds the
+ * chunks it takes into it with fold, chunks being divided among threads
+ * as by cvec_parallel_for; then each accumulator is combined into result
+ * with combine, on the calling thread. Since which thread takes which
+ * chunk varies from run to run, fold and combine must together give the
+ * same result in any grouping and order (as addition of integers does,
+ * but addition of floating point does only approximately). The CVector
+ * is not modified. An assert is raised if grain is negative, resultsz is
+ * 0, or on allocation or thread creation failure.
+ * Operates in N/nthreads-time.
+ *
+ * Asserts: negative grain, zero resultsz, allocation failure, thread creation failure
+ * Assumes: fold and combine are valid and safe to call from several threads
+ */
+void cvec_parallel_reduce(const CVector *cv, FoldFn fold, CombineFn combine, void *ctx,
+                          int grain, void *result, size_t resultsz);
+
+#endif
@@ -0,0 +1,199 @@
+/* File: cvector_sort.h
+ * --------------------
+ * Defines a macro generator for sorts with an inlined comparison.
+ *
+ * cvec_sort passes the elements to qsort, which calls the client's
+ * CompareFn through a pointer for every comparison and moves elements
+ * byte by byte, since it knows only their size. For small elements such
+ * as ints, those calls are most of the cost of the sort. For one known
+ * element type, CVEC_SORT_DEFINE(name, T, less_expr) generates sorting
+ * functions in which the comparison is an expression the compiler can
+ * inline, and elements are moved by assignment.
+ *
+ * less_expr is an expression in two values a and b of type T that is
+ * true if a must sort before b, such as a < b, or a.score < b.score.
+ * It must be a strict weak order (false for equal elements).
+ *
+ * Example:
+ *
+ *     CVEC_SORT_DEFINE(intsort, int, a < b)
+ *
+ *     intsort_sort(cvec_data(cv), cvec_count(cv));
+ *
+ * CVEC_SORT_DEFINE(name, T, less_expr) defines these functions:
+ *
+ *   void name_sort(T *base, size_t n)
+ *       Sorts n elements in place with an introsort: quicksort with a
+ *       median-of-three pivot, switching to insertion sort for short
+ *       ranges and to heapsort if the recursion gets too deep, so it is
+ *       NlgN in the worst case. As in pdqsort, a partition that moved
+ *       nothing is taken as a sign that the input is already (nearly)
+ *       sorted, and a bounded insertion sort is tried on both sides, so
+ *       sorted and nearly sorted input take close to linear time. Not
+ *       stable.
+ *   void name_stable_sort(T *base, size_t n)
+ *       Sorts n elements in place with a merge sort that keeps elements
+ *       that compare equal in their original order. Needs a temporary
+ *       array of n/2 elements; an assert is raised if it cannot be
+ *       allocated. Halves that are already in order are not merged, so
+ *       sorted input takes linear time.
+ *
+ * The functions work on any array, such as the storage of a CVector
+ * from cvec_data or of a typed vector from name_data.
+ */
+
+#ifndef _cvector_sort_h
+#define _cvector_sort_h
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ranges this short are insertion sorted
+#ifndef CVEC_SORT_INSERTION
+#define CVEC_SORT_INSERTION 16
+#endif
+
+// elements a presorted-input check may move before giving up
+#ifndef CVEC_SORT_PARTIAL_LIMIT
+#define CVEC_SORT_PARTIAL_LIMIT 8
+#endif
+
+#define CVEC_SORT_DEFINE(name, T, less_expr)                                  \
+                                                                              \
+static inline int name##_less(T a, T b) {                                     \
+    return (less_expr);                                                       \
+}                                                                             \
+                                                                              \
+static inline void name##_swap(T *p, T *q) {                                  \
+    T x = *p;                                                                 \
+    *p = *q;                                                                  \
+    *q = x;                                                                   \
+}                                                                             \
+                                                                              \
+static inline void name##_insertion(T *base, size_t n) {                      \
+    for(size_t i = 1; i < n; i++) {                                           \
+        T x = base[i];                                                        \
+        size_t j = i;                                                         \
+        for(; j > 0 && name##_less(x, base[j-1]); j--) base[j] = base[j-1];   \
+        base[j] = x;                                                          \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* insertion sort that gives up once it has moved too many elements */        \
+static inline int name##_partial_insertion(T *base, size_t n) {               \
+    size_t moved = 0;                                                         \
+    for(size_t i = 1; i < n; i++) {                                           \
+        if(!name##_less(base[i], base[i-1])) continue;                        \
+        T x = base[i];                                                        \
+        size_t j = i;                                                         \
+        do {                                                                  \
+            base[j] = base[j-1];                                              \
+            j--;                                                              \
+        } while(j > 0 && name##_less(x, base[j-1]));                          \
+        base[j] = x;                                                          \
+        moved += i - j;                                                       \
+        if(moved > CVEC_SORT_PARTIAL_LIMIT) return 0;                         \
+    }                                                                         \
+    return 1;                                                                 \
+}                                                                             \
+                                                                              \
+static void name##_siftdown(T *base, size_t i, size_t n) {                    \
+    T x = base[i];                                                            \
+    for(size_t child; (child = 2*i + 1) < n; i = child) {                     \
+        if(child + 1 < n && name##_less(base[child], base[child+1])) child++; \
+        if(!name##_less(x, base[child])) break;                               \
+        base[i] = base[child];                                                \
+    }                                                                         \
+    base[i] = x;                                                              \
+}                                                                             \
+                                                                              \
+static void name##_heapsort(T *base, size_t n) {                              \
+    for(size_t i = n / 2; i-- > 0; ) name##_siftdown(base, i, n);             \
+    for(size_t end = n - 1; end > 0; end--) {                                 \
+        name##_swap(&base[0], &base[end]);                                    \
+        name##_siftdown(base, 0, end);                                        \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void name##_introsort(T *base, size_t n, int depth) {                  \
+    while(n > CVEC_SORT_INSERTION) {                                          \
+        if(depth-- == 0) {                                                    \
+            name##_heapsort(base, n);                                         \
+            return;                                                           \
+        }                                                                     \
+        /* median of three: *lo <= *md <= *hi, */                             \
+        /* then the median moves to base[0] as the pivot */                   \
+        T *lo = base, *md = base + n / 2, *hi = base + n - 1;                 \
+        if(name##_less(*md, *lo)) name##_swap(md, lo);                        \
+        if(name##_less(*hi, *md)) {                                           \
+            name##_swap(hi, md);                                              \
+            if(name##_less(*md, *lo)) name##_swap(md, lo);                    \
+        }                                                                     \
+        name##_swap(md, lo);                                                  \
+                                                                              \
+        /* Hoare partition; base[0] and base[n-1] bound both scans */         \
+        T pivot = base[0];                                                    \
+        size_t i = 0, j = n;                                                  \
+        int swapped = 0;                                                      \
+        for(;;) {                                                             \
+            do i++; while(name##_less(base[i], pivot));                       \
+            do j--; while(name##_less(pivot, base[j]));                       \
+            if(i >= j) break;                                                 \
+            name##_swap(&base[i], &base[j]);                                  \
+            swapped = 1;                                                      \
+        }                                                                     \
+        base[0] = base[j];                                                    \
+        base[j] = pivot;                                                      \
+                                                                              \
+        /* no swaps means the input was likely already in order */            \
+        if(!swapped && name##_partial_insertion(base, j) &&                   \
+           name##_partial_insertion(base + j + 1, n - j - 1)) return;         \
+                                                                              \
+        /* recurse into the smaller side, loop on the larger */               \
+        if(j < n - j - 1) {                                                   \
+            name##_introsort(base, j, depth);                                 \
+            base += j + 1;                                                    \
+            n -= j + 1;                                                       \
+        } else {                                                              \
+            name##_introsort(base + j + 1, n - j - 1, depth);                 \
+            n = j;                                                            \
+        }                                                                     \
+    }                                                                         \
+    name##_insertion(base, n);                                                \
+}                                                                             \
+                                                                              \
+static inline void name##_sort(T *base, size_t n) {                           \
+    int depth = 0;                                                            \
+    for(size_t m = n; m > 1; m >>= 1) depth += 2;                             \
+    name##_introsort(base, n, depth);                                         \
+}                                                                             \
+                                                                              \
+static void name##_merge_sort(T *base, size_t n, T *buf) {                    \
+    if(n <= CVEC_SORT_INSERTION) {                                            \
+        name##_insertion(base, n);                                            \
+        return;                                                               \
+    }                                                                         \
+    size_t mid = n / 2;                                                       \
+    name##_merge_sort(base, mid, buf);                                        \
+    name##_merge_sort(base + mid, n - mid, buf);                              \
+    /* halves already in order */                                             \
+    if(!name##_less(base[mid], base[mid-1])) return;                          \
+                                                                              \
+    memcpy(buf, base, mid * sizeof(T));                                       \
+    size_t i = 0, j = mid, k = 0;                                             \
+    /* take from the right half only if strictly less, for stability */       \
+    while(i < mid && j < n)                                                   \
+        base[k++] = name##_less(base[j], buf[i]) ? base[j++] : buf[i++];      \
+    while(i < mid) base[k++] = buf[i++];                                      \
+}                                                                             \
+                                                                              \
+static inline void name##_stable_sort(T *base, size_t n) {                    \
+    if(n < 2) return;                                                         \
+    T *buf = malloc((n / 2) * sizeof(T));                                     \
+    assert(buf != NULL);                                                      \
+    name##_merge_sort(base, n, buf);                                          \
+    free(buf);                                                                \
+}
+
+#endif
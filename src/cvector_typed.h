@@ -0,0 +1,142 @@
+/* File: cvector_typed.h
+ * ---------------------
+ * Defines a macro generator for type-specialized vectors.
+ *
+ * The CVector works for any element type by passing elements through
+ * void* pointers and computing addresses from an element size stored at
+ * runtime. That generality costs a function call and a multiply on every
+ * access, and hides the element type from the compiler. For a vector of
+ * one known type, CVECTOR_DEFINE(name, T) generates a struct and a set of
+ * static inline functions in which the element type and size are fixed
+ * at compile time. Accesses then compile to plain array indexing, and
+ * loops over the elements can be inlined and vectorized.
+ *
+ * The generated vector follows the CVector semantics: it is created on
+ * the heap and disposed of by the client, indexes are ints checked by
+ * assert, storage doubles when full, allocation failure raises an assert,
+ * and an optional cleanup function is applied to removed elements and to
+ * every element on dispose. Unlike the CVector, the struct is visible so
+ * that the functions can be inlined; clients should still use only the
+ * generated functions rather than touching the fields.
+ *
+ * Example:
+ *
+ *     CVECTOR_DEFINE(intvec, int)
+ *
+ *     intvec *v = intvec_create(0, NULL);
+ *     for (int i = 0; i < 100; i++)
+ *         intvec_append(v, i);
+ *     int sum = 0;
+ *     for (int i = 0; i < intvec_count(v); i++)
+ *         sum += *intvec_nth(v, i);
+ *     intvec_dispose(v);
+ *
+ * CVECTOR_DEFINE(name, T) defines the type name and these functions:
+ *
+ *   name *name_create(int capacity_hint, void (*fn)(T *))
+ *   void  name_dispose(name *v)
+ *   int   name_count(const name *v)
+ *   T    *name_nth(const name *v, int index)     asserts valid index
+ *   T    *name_data(const name *v)               all elements, contiguous
+ *   void  name_reserve(name *v, int capacity)
+ *   void  name_append(name *v, T elem)
+ *   void  name_insert(name *v, T elem, int index)
+ *   void  name_remove(name *v, int index)
+ *
+ * Elements are passed in and out by value (or T * for access in place),
+ * so no casts are needed. As with cvec_nth, a pointer returned by
+ * name_nth or name_data becomes invalid on any call that adds elements.
+ */
+
+#ifndef _cvector_typed_h
+#define _cvector_typed_h
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// capacity used when given capacity_hint is 0, same as CVector
+#define CVECTOR_TYPED_DEFAULT_CAPACITY 16
+
+#define CVECTOR_DEFINE(name, T)                                               \
+                                                                              \
+typedef struct name {                                                         \
+    T *data;                                                                  \
+    int size;                                                                 \
+    int capacity;                                                             \
+    void (*clean)(T *);                                                       \
+} name;                                                                       \
+                                                                              \
+static inline name *name##_create(int capacity_hint, void (*fn)(T *)) {       \
+    name *v = malloc(sizeof(name));                                           \
+    assert(v != NULL);                                                        \
+    if(capacity_hint <= 0) capacity_hint = CVECTOR_TYPED_DEFAULT_CAPACITY;    \
+    v->data = malloc(sizeof(T) * capacity_hint);                              \
+    assert(v->data != NULL);                                                  \
+    v->size = 0;                                                              \
+    v->capacity = capacity_hint;                                              \
+    v->clean = fn;                                                            \
+    return v;                                                                 \
+}                                                                             \
+                                                                              \
+static inline void name##_dispose(name *v) {                                  \
+    if(v->clean != NULL) {                                                    \
+        for(int i = 0; i < v->size; i++) v->clean(&v->data[i]);               \
+    }                                                                         \
+    free(v->data);                                                            \
+    free(v);                                                                  \
+}                                                                             \
+                                                                              \
+static inline int name##_count(const name *v) {                               \
+    return v->size;                                                           \
+}                                                                             \
+                                                                              \
+static inline T *name##_nth(const name *v, int index) {                       \
+    assert(index >= 0 && index < v->size);                                    \
+    return &v->data[index];                                                   \
+}                                                                             \
+                                                                              \
+static inline T *name##_data(const name *v) {                                 \
+    return v->data;                                                           \
+}                                                                             \
+                                                                              \
+/* slow path kept out of line so appends inline to a compare and a store */  \
+static void name##_grow(name *v, int mincap) {                                \
+    int capacity = v->capacity;                                               \
+    while(capacity < mincap) capacity *= 2;                                   \
+    v->data = realloc(v->data, sizeof(T) * capacity);                         \
+    assert(v->data != NULL);                                                  \
+    v->capacity = capacity;                                                   \
+}                                                                             \
+                                                                              \
+static inline void name##_reserve(name *v, int capacity) {                    \
+    if(capacity > v->capacity) {                                              \
+        v->data = realloc(v->data, sizeof(T) * capacity);                     \
+        assert(v->data != NULL);                                              \
+        v->capacity = capacity;                                               \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static inline void name##_append(name *v, T elem) {                           \
+    if(v->size == v->capacity) name##_grow(v, v->size + 1);                   \
+    v->data[v->size++] = elem;                                                \
+}                                                                             \
+                                                                              \
+static inline void name##_insert(name *v, T elem, int index) {                \
+    assert(index >= 0 && index <= v->size);                                   \
+    if(v->size == v->capacity) name##_grow(v, v->size + 1);                   \
+    memmove(&v->data[index + 1], &v->data[index],                             \
+            sizeof(T) * (v->size - index));                                   \
+    v->data[index] = elem;                                                    \
+    v->size++;                                                                \
+}                                                                             \
+                                                                              \
+static inline void name##_remove(name *v, int index) {                        \
+    assert(index >= 0 && index < v->size);                                    \
+    if(v->clean != NULL) v->clean(&v->data[index]);                           \
+    memmove(&v->data[index], &v->data[index + 1],                             \
+            sizeof(T) * (v->size - index - 1));                               \
+    v->size--;                                                                \
+}
+
+#endif
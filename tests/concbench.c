@@ -0,0 +1,130 @@
+/* File: concbench.c
+ * -----------------
+ * Times concurrent appends from 1, 2, 4 and 8 producer threads, each
+ * appending its share of nappends 16-byte records, into a CConcVector and
+ * into a CVector guarded by a mutex, and checks that every record arrives.
+ * Appends per second should grow with producers for the CConcVector as
+ * long as there are processors to run them, while the locked CVector
+ * serializes every append. On a machine with fewer processors than
+ * producers, the threads only take turns and neither can scale.
+ * Usage: concbench [nappends]
+ */
+
+#include "cconcvec.h"
+#include "cvector.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_NAPPENDS 16000000
+#define MAXPRODUCERS 8
+
+typedef struct {
+    uint64_t producer, seq;
+} Record;
+
+typedef struct {
+    CConcVector *cc; // appended to if not NULL, else cv under lock
+    CVector *cv;
+    pthread_mutex_t *lock;
+    int id, nappends;
+} Producer;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *produce(void *arg)
+{
+    Producer *p = arg;
+    for (int i = 0; i < p->nappends; i++) {
+        Record r = { p->id, i };
+        if (p->cc != NULL) {
+            cconcvec_append(p->cc, &r);
+        } else {
+            pthread_mutex_lock(p->lock);
+            cvec_append(p->cv, &r);
+            pthread_mutex_unlock(p->lock);
+        }
+    }
+    return NULL;
+}
+
+/* Function: run
+ * -------------
+ * Starts nproducers threads appending nappends records between them into
+ * cc, or into cv under a mutex if cc is NULL, and returns the time until
+ * the last one finishes.
+ */
+static double run(CConcVector *cc, CVector *cv, int nproducers, int nappends)
+{
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_t threads[MAXPRODUCERS];
+    Producer args[MAXPRODUCERS];
+    double start = now();
+    for (int i = 0; i < nproducers; i++) {
+        args[i] = (Producer){ cc, cv, &lock, i, nappends / nproducers };
+        pthread_create(&threads[i], NULL, produce, &args[i]);
+    }
+    for (int i = 0; i < nproducers; i++)
+        pthread_join(threads[i], NULL);
+    return now() - start;
+}
+
+/* Function: count_ok
+ * ------------------
+ * Checks that count records arrived and that each producer's records are
+ * in the order it appended them.
+ */
+static int count_ok(void *(*nth)(void *, int), void *vec, int count, int nproducers, int nappends)
+{
+    uint64_t next[MAXPRODUCERS] = { 0 };
+    if (count != nappends / nproducers * nproducers) return 0;
+    for (int i = 0; i < count; i++) {
+        Record *r = nth(vec, i);
+        if (r == NULL || r->producer >= nproducers || r->seq != next[r->producer]++) return 0;
+    }
+    return 1;
+}
+
+static void *conc_nth(void *vec, int i)
+{
+    return cconcvec_nth(vec, i);
+}
+
+static void *vec_nth(void *vec, int i)
+{
+    return cvec_nth(vec, i);
+}
+
+int main(int argc, char *argv[])
+{
+    int nappends = (argc > 1) ? atoi(argv[1]) : DEFAULT_NAPPENDS;
+    printf("Appending %d records from 1 to %d producers on %ld processors\n",
+           nappends, MAXPRODUCERS, sysconf(_SC_NPROCESSORS_ONLN));
+
+    int failures = 0;
+    for (int t = 1; t <= MAXPRODUCERS; t *= 2) {
+        CConcVector *cc = cconcvec_create(sizeof(Record), 0, NULL);
+        double conc = run(cc, NULL, t, nappends);
+        int ok = count_ok(conc_nth, cc, cconcvec_count(cc), t, nappends);
+        cconcvec_dispose(cc);
+
+        CVector *cv = cvec_create(sizeof(Record), 0, NULL);
+        double locked = run(NULL, cv, t, nappends);
+        ok = ok && count_ok(vec_nth, cv, cvec_count(cv), t, nappends);
+        cvec_dispose(cv);
+
+        printf("%d producers   cconcvec %6.1f M/s   locked cvector %6.1f M/s  (%.1fx)  %s\n",
+               t, nappends / conc / 1e6, nappends / locked / 1e6, locked / conc,
+               ok ? "All records in order." : "##### RECORDS MISSING #####");
+        failures += !ok;
+    }
+    return failures != 0;
+}
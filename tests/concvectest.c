@@ -0,0 +1,125 @@
+/* File: concvectest.c
+ * -------------------
+ * Exercises the CConcVector: indexing across buckets, stability of
+ * element addresses across appends, and many producer threads appending
+ * while reader threads follow the published count.
+ */
+
+#include "cconcvec.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static void verify_int(int expected, int found, char *msg)
+{
+    printf("%s expect: %d found: %d. %s\n", msg, expected, found,
+        (expected == found) ? "Seems ok." : "##### PROBLEM HERE #####");
+}
+
+
+/* Function: simple_concvec
+ * ------------------------
+ * Appends across many buckets from one thread and checks values, and
+ * that a pointer taken early still points at the same element at the end.
+ */
+static void simple_concvec()
+{
+    printf("\n----------------- Testing simple concvec ------------------ \n");
+    CConcVector *cc = cconcvec_create(sizeof(int), 4, NULL);
+    int zero = 0;
+    verify_int(0, cconcvec_append(cc, &zero), "Index of first append");
+    int *first = cconcvec_nth(cc, 0);
+    for (int i = 1; i < 100000; i++)
+        cconcvec_append(cc, &i);
+    verify_int(100000, cconcvec_count(cc), "cconcvec_count");
+    verify_int(100000, cconcvec_published(cc), "cconcvec_published");
+    int mismatches = 0;
+    for (int i = 0; i < 100000; i++)
+        if (*(int *)cconcvec_nth(cc, i) != i) mismatches++;
+    verify_int(0, mismatches, "Values out of place");
+    verify_int(1, first == cconcvec_nth(cc, 0), "Address of element 0 unchanged");
+    cconcvec_dispose(cc);
+}
+
+
+#define NPRODUCERS 4
+#define NREADERS 2
+#define NAPPENDS 500000 // per producer
+
+typedef struct {
+    int producer;
+    int seq;
+} Entry;
+
+typedef struct {
+    CConcVector *cc;
+    int id;
+} Producer;
+
+static void *producer(void *arg)
+{
+    Producer *p = arg;
+    for (int i = 0; i < NAPPENDS; i++) {
+        Entry e = { p->id, i };
+        cconcvec_append(p->cc, &e);
+    }
+    return NULL;
+}
+
+/* Function: reader
+ * ----------------
+ * Follows the published count while producers append, checking that each
+ * producer's entries appear in the order it appended them. Any torn or
+ * unpublished read shows up as a sequence out of order.
+ */
+static void *reader(void *arg)
+{
+    CConcVector *cc = arg;
+    int next[NPRODUCERS] = { 0 };
+    long bad = 0;
+    int seen = 0;
+    while (seen < NPRODUCERS * NAPPENDS) {
+        int n = cconcvec_published(cc);
+        for (; seen < n; seen++) {
+            Entry *e = cconcvec_nth(cc, seen);
+            if (e == NULL || e->producer < 0 || e->producer >= NPRODUCERS || e->seq != next[e->producer]++)
+                bad++;
+        }
+    }
+    return (void *)bad;
+}
+
+static void concurrent_concvec()
+{
+    printf("\n----------------- Testing concurrent producers ------------------ \n");
+    CConcVector *cc = cconcvec_create(sizeof(Entry), 64, NULL);
+    pthread_t readers[NREADERS], producers[NPRODUCERS];
+    Producer args[NPRODUCERS];
+    for (int i = 0; i < NREADERS; i++)
+        pthread_create(&readers[i], NULL, reader, cc);
+    for (int i = 0; i < NPRODUCERS; i++) {
+        args[i] = (Producer){ cc, i };
+        pthread_create(&producers[i], NULL, producer, &args[i]);
+    }
+    for (int i = 0; i < NPRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+    long bad = 0;
+    for (int i = 0; i < NREADERS; i++) {
+        void *result;
+        pthread_join(readers[i], &result);
+        bad += (long)result;
+    }
+    verify_int(0, bad, "Bad reads");
+    verify_int(NPRODUCERS * NAPPENDS, cconcvec_count(cc), "cconcvec_count");
+    verify_int(NPRODUCERS * NAPPENDS, cconcvec_published(cc), "cconcvec_published");
+    cconcvec_dispose(cc);
+}
+
+
+int main(void)
+{
+    simple_concvec();
+    concurrent_concvec();
+    return 0;
+}
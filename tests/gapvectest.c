@@ -0,0 +1,113 @@
+/* File: gapvectest.c
+ * ------------------
+ * Exercises the CGapVector: editor-style typing and deleting at a cursor,
+ * and a long run of random clustered edits checked against a CVector
+ * receiving the same edits.
+ */
+
+#include "cgapvec.h"
+#include "cvector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void verify_int(int expected, int found, char *msg)
+{
+    printf("%s expect: %d found: %d. %s\n", msg, expected, found,
+        (expected == found) ? "Seems ok." : "##### PROBLEM HERE #####");
+}
+
+static void verify_str(const char *expected, const char *found, char *msg)
+{
+    printf("%s expect: \"%s\" found: \"%s\". %s\n", msg, expected, found,
+        (strcmp(expected, found) == 0) ? "Seems ok." : "##### PROBLEM HERE #####");
+}
+
+
+/* Function: type_text
+ * -------------------
+ * Inserts the characters of a string one by one at a cursor, which
+ * advances past each one, the way an editor handles typing.
+ */
+static int type_text(CGapVector *gv, int cursor, const char *text)
+{
+    for (; *text != '\0'; text++)
+        cgapvec_insert(gv, text, cursor++);
+    return cursor;
+}
+
+/* Function: editor_test
+ * ---------------------
+ * Types, moves the cursor, deletes backward and forward, and checks the
+ * text after each step.
+ */
+static void editor_test()
+{
+    printf("\n----------------- Testing editor edits ------------------ \n");
+    CGapVector *gv = cgapvec_create(sizeof(char), 4, NULL);
+    int cursor = type_text(gv, 0, "hello world");
+    verify_int(11, cgapvec_count(gv), "cgapvec_count");
+
+    cursor = type_text(gv, 5, ",");                  // hello, world
+    cursor = type_text(gv, cgapvec_count(gv), "!!"); // hello, world!!
+    cgapvec_remove(gv, --cursor);                    // backspace
+    char nul = '\0';
+    cgapvec_append(gv, &nul);
+    verify_str("hello, world!", cgapvec_data(gv), "Text");
+    cgapvec_remove(gv, cgapvec_count(gv) - 1);
+
+    for (int i = 0; i < 7; i++)
+        cgapvec_remove(gv, 0);                       // forward delete at start
+    type_text(gv, 0, "brave new ");
+    cgapvec_append(gv, &nul);
+    verify_str("brave new world!", cgapvec_data(gv), "Text");
+    verify_int('w', *(char *)cgapvec_nth(gv, 10), "*value for cgapvec_nth(10)");
+    cgapvec_dispose(gv);
+}
+
+
+/* Function: random_test
+ * ---------------------
+ * Applies the same random edits to a CGapVector and a CVector. Edits
+ * mostly land near the previous one, sometimes jump anywhere.
+ */
+static void random_test(int nedits)
+{
+    printf("\n----------------- Testing random clustered edits ------------------ \n");
+    CGapVector *gv = cgapvec_create(sizeof(int), 0, NULL);
+    CVector *cv = cvec_create(sizeof(int), 0, NULL);
+    srand(107);
+    int pos = 0, mismatches = 0;
+    for (int i = 0; i < nedits; i++) {
+        int count = cvec_count(cv);
+        if (rand() % 20 == 0) pos = rand() % (count + 1);
+        else pos += rand() % 3 - 1;
+        if (pos < 0) pos = 0;
+        if (pos > count) pos = count;
+
+        if (count > 0 && pos < count && rand() % 3 == 0) {
+            cgapvec_remove(gv, pos);
+            cvec_remove(cv, pos);
+        } else {
+            cgapvec_insert(gv, &i, pos);
+            cvec_insert(cv, &i, pos);
+        }
+        int probe = rand() % (cvec_count(cv) + 1);
+        if (probe < cvec_count(cv) &&
+            *(int *)cgapvec_nth(gv, probe) != *(int *)cvec_nth(cv, probe)) mismatches++;
+    }
+    verify_int(cvec_count(cv), cgapvec_count(gv), "cgapvec_count");
+    verify_int(0, mismatches, "Mismatched probes");
+    verify_int(0, memcmp(cvec_data(cv), cgapvec_data(gv), cvec_count(cv) * sizeof(int)),
+        "memcmp of all elements");
+    cgapvec_dispose(gv);
+    cvec_dispose(cv);
+}
+
+int main(int argc, char *argv[])
+{
+    editor_test();
+    random_test(200000);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* File: growbench.c
+ * -----------------
+ * Appends many ints to a CVector under each growth policy and reports the
+ * peak resident memory, the bytes copied by reallocations that moved the
+ * buffer, and the time taken. Each policy runs in its own child process
+ * so that peak RSS is measured separately. The moved figure counts the
+ * payload of every reallocation below the mmap threshold that returned a
+ * new address (malloc'ed storage, plus the one copy into a mapping when
+ * storage crosses the threshold). Mapped storage grows with mremap, which
+ * moves page mappings without copying, so its payload is reported apart
+ * as remapped. On systems without mremap, remapped bytes were copied too.
+ * Usage: growbench [nelems] [chunk]
+ */
+
+#include "cvector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define DEFAULT_NELEMS 100000000
+#define DEFAULT_CHUNK (16 * 1024 * 1024)
+#define MMAP_THRESHOLD (64UL << 20) // CVEC_MMAP_THRESHOLD in cvector.c
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Function: append_all
+ * --------------------
+ * Appends nelems ints, noticing each time the buffer moves so the bytes
+ * copied by realloc, and those remapped by mremap, can be totalled. Runs
+ * in the child process.
+ */
+static void append_all(const char *name, CVecGrowth growth, size_t chunk, int nelems)
+{
+    CVector *cv = cvec_create_growth(sizeof(int), 0, NULL, growth, chunk);
+    double moved = 0, remapped = 0;
+    void *base = NULL;
+    size_t capacity = 0;
+    double start = now();
+    for (int i = 0; i < nelems; i++) {
+        cvec_append(cv, &i);
+        void *cur = cvec_nth(cv, 0);
+        if (cur != base && base != NULL) {
+            double bytes = (double)i * sizeof(int); // elements present before this append
+            if (capacity * sizeof(int) >= MMAP_THRESHOLD) remapped += bytes; // was already mapped
+            else moved += bytes;
+        }
+        base = cur;
+        capacity = cvec_capacity(cv);
+    }
+    double elapsed = now() - start;
+    printf("%-7s %8.2f s  moved %10.1f MB  remapped %10.1f MB  capacity %10zu  ", name, elapsed,
+        moved / (1 << 20), remapped / (1 << 20), cvec_capacity(cv));
+    fflush(stdout);
+    cvec_dispose(cv);
+}
+
+static void run(const char *name, CVecGrowth growth, size_t chunk, int nelems)
+{
+    fflush(stdout); // so the child does not repeat buffered output
+    pid_t pid = fork();
+    if (pid == 0) {
+        append_all(name, growth, chunk, nelems);
+        exit(0);
+    }
+    int status;
+    struct rusage ru;
+    wait4(pid, &status, 0, &ru);
+    printf("peak RSS %8.1f MB\n", ru.ru_maxrss / 1024.0);
+}
+
+int main(int argc, char *argv[])
+{
+    int nelems = (argc > 1) ? atoi(argv[1]) : DEFAULT_NELEMS;
+    size_t chunk = (argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_CHUNK;
+    printf("Appending %d ints (%.1f MB of data)\n", nelems, nelems * sizeof(int) / (double)(1 << 20));
+    run("double", CVEC_GROW_DOUBLE, 0, nelems);
+    run("half", CVEC_GROW_HALF, 0, nelems);
+    run("chunk", CVEC_GROW_CHUNK, chunk, nelems);
+    return 0;
+}
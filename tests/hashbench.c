@@ -0,0 +1,82 @@
+/* File: hashbench.c
+ * -----------------
+ * Measures CMap throughput with each hash function, so a table can pick
+ * between the cheap seeded hash and the flood-resistant SipHash.
+ * Usage: hashbench [nkeys]
+ */
+
+#include "cmap.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_NKEYS 1000000
+#define MAXLETTERS 9 // each key is 4 to MAXLETTERS letters, then its number
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Function: make_keys
+ * -------------------
+ * Builds nkeys distinct word-like keys of varying length packed into
+ * one buffer, *keylen bytes apart: room for the most letters, the digits
+ * of the largest number and the terminator.
+ */
+static char *make_keys(int nkeys, size_t *keylen)
+{
+    *keylen = MAXLETTERS + snprintf(NULL, 0, "%d", nkeys) + 1;
+    char *keys = malloc((size_t)nkeys * *keylen);
+    assert(keys != NULL);
+    for (int i = 0; i < nkeys; i++) {
+        char *k = keys + (size_t)i * *keylen;
+        int len = 4 + rand() % (MAXLETTERS - 3);
+        for (int j = 0; j < len; j++)
+            k[j] = 'a' + rand() % 26;
+        sprintf(k + len, "%d", i); // suffix keeps keys distinct
+    }
+    return keys;
+}
+
+static void run(const char *name, CMapHashKind kind, const char *keys, int nkeys, size_t keylen)
+{
+    CMap *cm = cmap_create(sizeof(int), nkeys, NULL);
+    cmap_set_hash(cm, kind, NULL);
+
+    double start = now();
+    for (int i = 0; i < nkeys; i++)
+        cmap_put(cm, keys + (size_t)i * keylen, &i);
+    double put = now() - start;
+
+    long sum = 0;
+    start = now();
+    for (int i = 0; i < nkeys; i++) {
+        int val;
+        memcpy(&val, cmap_get(cm, keys + (size_t)i * keylen), sizeof(int)); // values follow keys unaligned
+        sum += val;
+    }
+    double get = now() - start;
+
+    CMapStats st;
+    cmap_stats(cm, &st);
+    printf("%-8s put %6.1f ns/op  get %6.1f ns/op  max chain %zu  (checksum %ld)\n",
+        name, put * 1e9 / nkeys, get * 1e9 / nkeys, st.max_chain, sum);
+    cmap_dispose(cm);
+}
+
+int main(int argc, char *argv[])
+{
+    int nkeys = (argc > 1) ? atoi(argv[1]) : DEFAULT_NKEYS;
+    size_t keylen;
+    char *keys = make_keys(nkeys, &keylen);
+    printf("%d keys, capacity hint = nkeys\n", nkeys);
+    run("fast", CMAP_HASH_FAST, keys, nkeys, keylen);
+    run("siphash", CMAP_HASH_SIPHASH, keys, nkeys, keylen);
+    free(keys);
+    return 0;
+}
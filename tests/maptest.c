@@ -85,12 +85,189 @@ void simple_cmap()
     for (const char *key = cmap_first(cm); key != NULL; key = cmap_next(cm, key))
         nkeys++;
     verify_int(cmap_count(cm), nkeys, "Number of keys");
-   
-    
+
+    printf("\nCheck table shape with cmap_stats.\n");
+    CMapStats st;
+    cmap_stats(cm, &st);
+    size_t chained = 0;
+    for (int i = 0; i < CMAP_STATS_HIST; i++)
+        chained += st.chain_hist[i];
+    verify_int(cmap_count(cm), st.count, "stats count");
+    verify_int(st.nbuckets, chained, "Buckets in histogram");
+    verify_int(1, st.used_buckets > 0 && st.used_buckets <= st.count, "Used buckets in range");
+    verify_int(1, st.max_chain >= 1 && st.blob_bytes > 0, "Chains and blobs nonempty");
+    printf("load %.2f, max chain %zu, %zu/%zu buckets used\n",
+        st.load_factor, st.max_chain, st.used_buckets, st.nbuckets);
+    verify_ptr(NULL, cmap_get(cm, "app"), "cmap_get(\"app\")");
+
+    cmap_dispose(cm);
+}
+
+
+/* Function: hash_test
+* --------------------
+* Fills a SipHash-keyed CMap and a fast-hash CMap with the same fixed seed
+* and checks that every key is found in both.
+*/
+static void hash_test()
+{
+    printf("\n----------------- Testing hash kinds ------------------ \n");
+    unsigned char seed[16] = "0123456789abcdef";
+    CMap *sip = cmap_create(sizeof(int), 100, NULL);
+    CMap *fast = cmap_create(sizeof(int), 100, NULL);
+    cmap_set_hash(sip, CMAP_HASH_SIPHASH, NULL);
+    cmap_set_hash(fast, CMAP_HASH_FAST, seed);
+
+    char buf[16];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(buf, "key%d", i);
+        cmap_put(sip, buf, &i);
+        cmap_put(fast, buf, &i);
+    }
+    int found = 0;
+    for (int i = 0; i < 1000; i++) {
+        sprintf(buf, "key%d", i);
+        int *a = cmap_get(sip, buf), *b = cmap_get(fast, buf);
+        if (a != NULL && b != NULL && *a == i && *b == i) found++;
+    }
+    verify_int(1000, found, "Keys found in both maps");
+    cmap_dispose(sip);
+    cmap_dispose(fast);
+}
+
+
+static int nevicted;
+
+static void count_evicted(void *p)
+{
+    nevicted++;
+}
+
+
+/* Function: lru_test
+* -------------------
+* Fills a 3-entry LRU CMap past its bound and checks that the least
+* recently used keys are the ones evicted.
+*/
+static void lru_test()
+{
+    printf("\n----------------- Testing LRU cmap ------------------ \n");
+    CMap *cache = cmap_create_lru(sizeof(int), 3, count_evicted);
+    int one = 1, two = 2, three = 3, four = 4, five = 5;
+    nevicted = 0;
+    cmap_put(cache, "one", &one);
+    cmap_put(cache, "two", &two);
+    cmap_put(cache, "three", &three);
+    cmap_get(cache, "one");            // recency: one, three, two
+    cmap_put(cache, "four", &four);    // evicts two
+    verify_int(3, cmap_count(cache), "cmap_count");
+    verify_int(1, nevicted, "Evictions");
+    verify_ptr(NULL, cmap_get(cache, "two"), "cmap_get(\"two\")");
+    verify_int_ptr(1, cmap_get(cache, "one"), "cmap_get(\"one\")");
+    cmap_put(cache, "three", &three);  // replace cleans old value; recency: three, one, four
+    cmap_put(cache, "five", &five);    // evicts four
+    verify_int(3, nevicted, "Cleanups");
+    verify_ptr(NULL, cmap_get(cache, "four"), "cmap_get(\"four\")");
+    verify_int_ptr(5, cmap_get(cache, "five"), "cmap_get(\"five\")");
+    cmap_dispose(cache);
+    verify_int(6, nevicted, "Cleanups after dispose");
+}
+
+
+/* Function: multi_test
+* ---------------------
+* Appends runs of values to keys of a multimap CMap, enough to force the
+* per-key storage to grow, and reads them back with cmap_get_all. Also
+* replaces a key's run with cmap_put_all and adds a key with no values.
+*/
+static void multi_test()
+{
+    printf("\n----------------- Testing multimap cmap ------------------ \n");
+    CMap *cm = cmap_create_multi(sizeof(int), 10, NULL);
+    char buf[16];
+    for (int i = 0; i < 100; i++) {
+        sprintf(buf, "key%d", i % 10);
+        cmap_append(cm, buf, &i);            // key<k> gets k, k+10, k+20, ...
+    }
+    verify_int(10, cmap_count(cm), "cmap_count");
+
+    int n, *vals = cmap_get_all(cm, "key3", &n);
+    verify_int(10, n, "Values for key3");
+    verify_int(93, vals[9], "Last value for key3");
+    verify_int_ptr(3, cmap_get(cm, "key3"), "cmap_get(\"key3\")");
+    verify_ptr(NULL, cmap_get_all(cm, "key10", &n), "cmap_get_all(\"key10\")");
+    verify_int(0, n, "Values for key10");
+
+    int total = 0;
+    for (const char *key = cmap_first(cm); key != NULL; key = cmap_next(cm, key)) {
+        cmap_get_all(cm, key, &n);
+        total += n;
+    }
+    verify_int(100, total, "Values over all keys");
+
+    int zero = 0;
+    cmap_put(cm, "key3", &zero);
+    cmap_get_all(cm, "key3", &n);
+    verify_int(1, n, "Values for key3 after put");
+
+    int run[3] = { 7, 8, 9 };
+    cmap_put_all(cm, "key4", run, 3);
+    vals = cmap_get_all(cm, "key4", &n);
+    verify_int(3, n, "Values for key4 after put_all");
+    verify_int(9, vals[2], "Last value for key4");
+    cmap_put_all(cm, "empty", NULL, 0);
+    verify_int(11, cmap_count(cm), "cmap_count with key with no values");
+    verify_int(1, cmap_get_all(cm, "empty", &n) != NULL, "Key with no values found");
+    verify_int(0, n, "Values for empty");
+    cmap_append(cm, "empty", &zero);
+    cmap_get_all(cm, "empty", &n);
+    verify_int(1, n, "Values for empty after append");
     cmap_dispose(cm);
 }
 
 
+/* Function: intern_test
+* ----------------------
+* Shares one CStrPool between two CMaps and checks that keys are interned:
+* equal strings come back as the same pointer from either map.
+*/
+static void intern_test()
+{
+    printf("\n----------------- Testing interned keys ------------------ \n");
+    CStrPool *pool = cstrpool_create(0);
+    CMap *a = cmap_create(sizeof(int), 10, NULL);
+    CMap *b = cmap_create_multi(sizeof(int), 10, NULL);
+    cmap_intern_keys(a, pool);
+    cmap_intern_keys(b, pool);
+
+    char buf[16];
+    for (int i = 0; i < 50; i++) {
+        sprintf(buf, "word%d", i % 20);
+        cmap_put(a, buf, &i);
+        cmap_append(b, buf, &i);
+    }
+    verify_int(20, cstrpool_count(pool), "cstrpool_count");
+    verify_int(20, cmap_count(a), "cmap_count");
+    verify_int_ptr(45, cmap_get(a, "word5"), "cmap_get(\"word5\")");
+    verify_ptr(NULL, cmap_get(a, "word20"), "cmap_get(\"word20\")");
+    verify_ptr(NULL, (void *)cstrpool_lookup(pool, "word20"), "cstrpool_lookup(\"word20\")");
+    verify_ptr((void *)cmap_first(a), (void *)cstrpool_intern(pool, cmap_first(a)), "Key is canonical");
+
+    int nkeys = 0, nvals = 0, n;
+    for (const char *key = cmap_first(b); key != NULL; key = cmap_next(b, key)) {
+        cmap_get_all(b, key, &n);
+        nkeys++;
+        nvals += n;
+    }
+    verify_int(20, nkeys, "Keys iterated");
+    verify_int(50, nvals, "Values iterated");
+
+    cmap_dispose(a);
+    cmap_dispose(b);
+    cstrpool_dispose(pool);
+}
+
+
 /* Function: frequency_test
 * -------------------------
 * Runs a test of the CMap to count letter frequencies from a file.
@@ -135,6 +312,10 @@ static void frequency_test()
 int main(int argc, char *argv[])
 {
     simple_cmap();
+    hash_test();
+    lru_test();
+    multi_test();
+    intern_test();
     frequency_test();
     return 0;
 }
@@ -0,0 +1,127 @@
+/* File: parallelbench.c
+ * ---------------------
+ * Times a bulk transform and a sum over a CVector of 64-bit integers,
+ * first as a serial cvec_first/cvec_next loop, then with cvec_parallel_for
+ * and cvec_parallel_reduce at 1, 2, 4, ... threads up to maxthreads
+ * (default: one per processor), and checks that every run computes the
+ * same values. Also checks a wrapped CVector with a small grain, so that
+ * chunks split at the wrap and threads steal from each other.
+ * Usage: parallelbench [nelems] [maxthreads]
+ */
+
+#include "cvector.h"
+#include "cvector_parallel.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_NELEMS 20000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t transform(uint64_t x)
+{
+    for (int r = 0; r < 8; r++)                     // a few rounds of work per element
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x;
+}
+
+static void transform_chunk(void *elems, int n, int index, void *ctx)
+{
+    uint64_t *x = elems;
+    for (int i = 0; i < n; i++)
+        x[i] = transform(x[i]);
+}
+
+static void sum_chunk(void *acc, const void *elems, int n, void *ctx)
+{
+    const uint64_t *x = elems;
+    uint64_t sum = *(uint64_t *)acc;
+    for (int i = 0; i < n; i++)
+        sum += x[i];
+    *(uint64_t *)acc = sum;
+}
+
+static void add_sums(void *acc, const void *other, void *ctx)
+{
+    *(uint64_t *)acc += *(const uint64_t *)other;
+}
+
+static CVector *fill(int nelems)
+{
+    CVector *cv = cvec_create(sizeof(uint64_t), nelems, NULL);
+    for (uint64_t i = 0; i < nelems; i++)
+        cvec_append(cv, &i);
+    return cv;
+}
+
+/* Function: wrapped_check
+ * -----------------------
+ * Transforms and sums a wrapped CVector in chunks of 7 and compares with
+ * the same work done serially.
+ */
+static int wrapped_check(void)
+{
+    CVector *cv = cvec_create(sizeof(uint64_t), 0, NULL);
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < 100000; i++) {
+        cvec_push_front(cv, &i);
+        expected += transform(i);
+    }
+    cvec_parallel_for(cv, transform_chunk, NULL, 7);
+    uint64_t sum = 0;
+    cvec_parallel_reduce(cv, sum_chunk, add_sums, NULL, 7, &sum, sizeof(sum));
+    int ok = (sum == expected) && *(uint64_t *)cvec_nth(cv, 0) == transform(99999);
+    printf("Wrapped CVector, grain 7:  %s\n", ok ? "Same result." : "##### RESULT DIFFERS #####");
+    cvec_dispose(cv);
+    return !ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int nelems = (argc > 1) ? atoi(argv[1]) : DEFAULT_NELEMS;
+    printf("Transforming and summing %d 64-bit integers\n", nelems);
+
+    CVector *cv = fill(nelems);
+    double start = now();
+    for (uint64_t *cur = cvec_first(cv); cur != NULL; cur = cvec_next(cv, cur))
+        *cur = transform(*cur);
+    double for_time = now() - start;
+    start = now();
+    uint64_t expected = 0;
+    for (uint64_t *cur = cvec_first(cv); cur != NULL; cur = cvec_next(cv, cur))
+        expected += *cur;
+    double sum_time = now() - start;
+    printf("serial loop              transform %7.3f s  sum %7.3f s\n", for_time, sum_time);
+    cvec_dispose(cv);
+
+    int mismatches = 0;
+    int maxthreads = (argc > 2) ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+    for (int t = 1; t <= maxthreads; t = (t * 2 > maxthreads && t < maxthreads) ? maxthreads : t * 2) {
+        cvec_parallel_set_threads(t);
+        cv = fill(nelems);
+        start = now();
+        cvec_parallel_for(cv, transform_chunk, NULL, 0);
+        double par_for = now() - start;
+        start = now();
+        uint64_t sum = 0;
+        cvec_parallel_reduce(cv, sum_chunk, add_sums, NULL, 0, &sum, sizeof(sum));
+        double par_sum = now() - start;
+        printf("parallel %3d threads     transform %7.3f s (%.1fx)  sum %7.3f s (%.1fx)  %s\n",
+               t, par_for, for_time / par_for, par_sum, sum_time / par_sum,
+               sum == expected ? "Same result." : "##### RESULT DIFFERS #####");
+        mismatches += (sum != expected);
+        cvec_dispose(cv);
+    }
+
+    cvec_parallel_set_threads((maxthreads > 4) ? maxthreads : 4);
+    mismatches += wrapped_check();
+    return mismatches != 0;
+}
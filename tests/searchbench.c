@@ -0,0 +1,115 @@
+/* File: searchbench.c
+ * -------------------
+ * Times random lookups in a large sorted CVector of ints: libc bsearch
+ * on the storage, cvec_search (branchless lower bound), cvec_search_many
+ * (sort the keys, then one galloping pass; also given presorted keys),
+ * and a CVecIndex searched one
+ * key at a time and in batches. Half of the keys are
+ * present. Checks that all methods agree on which keys are found.
+ * Usage: searchbench [nelems] [nlookups]
+ */
+
+#include "cvector.h"
+#include "cvecindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_NELEMS 100000000
+#define DEFAULT_NLOOKUPS 10000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int cmp_int(const void *p1, const void *p2)
+{
+    int a = *(const int *)p1, b = *(const int *)p2;
+    return (a > b) - (a < b);
+}
+
+static void report(const char *name, double elapsed, double base, int nlookups, long hits)
+{
+    printf("%-24s %7.3f s  %6.1f ns/lookup  (%.1fx)  %ld found\n", name, elapsed,
+        elapsed * 1e9 / nlookups, base / elapsed, hits);
+}
+
+int main(int argc, char *argv[])
+{
+    int nelems = (argc > 1) ? atoi(argv[1]) : DEFAULT_NELEMS;
+    int nlookups = (argc > 2) ? atoi(argv[2]) : DEFAULT_NLOOKUPS;
+    printf("Looking up %d keys among %d sorted ints\n", nlookups, nelems);
+
+    // even values, so odd keys miss
+    CVector *cv = cvec_create(sizeof(int), nelems, NULL);
+    for (int i = 0; i < nelems; i++) {
+        int val = 2 * i;
+        cvec_append(cv, &val);
+    }
+    int *keys = malloc(nlookups * sizeof(int)), *found = malloc(nlookups * sizeof(int));
+    srand(1);
+    for (int i = 0; i < nlookups; i++)
+        keys[i] = (int)(((long)rand() * RAND_MAX + rand()) % (2L * nelems));
+
+    long hits = 0;
+    double elapsed, start = now();
+    for (int i = 0; i < nlookups; i++)
+        hits += bsearch(&keys[i], cvec_data(cv), nelems, sizeof(int), cmp_int) != NULL;
+    double base = now() - start;
+    report("bsearch", base, base, nlookups, hits);
+
+    hits = 0;
+    start = now();
+    for (int i = 0; i < nlookups; i++)
+        hits += cvec_search(cv, &keys[i], cmp_int, 0, true) >= 0;
+    report("cvec_search", now() - start, base, nlookups, hits);
+
+    hits = 0;
+    start = now();
+    cvec_search_many(cv, keys, nlookups, cmp_int, found);
+    elapsed = now() - start;
+    for (int i = 0; i < nlookups; i++)
+        hits += found[i] >= 0;
+    report("cvec_search_many", elapsed, base, nlookups, hits);
+
+    // keys that arrive sorted skip the internal sort
+    int *sorted_keys = malloc(nlookups * sizeof(int));
+    memcpy(sorted_keys, keys, nlookups * sizeof(int));
+    qsort(sorted_keys, nlookups, sizeof(int), cmp_int);
+    hits = 0;
+    start = now();
+    cvec_search_many(cv, sorted_keys, nlookups, cmp_int, found);
+    elapsed = now() - start;
+    for (int i = 0; i < nlookups; i++)
+        hits += found[i] >= 0;
+    report("cvec_search_many sorted", elapsed, base, nlookups, hits);
+    free(sorted_keys);
+
+    start = now();
+    CVecIndex *ix = cvec_index_create(cv, cmp_int);
+    printf("cvec_index_create        %7.3f s\n", now() - start);
+
+    hits = 0;
+    start = now();
+    for (int i = 0; i < nlookups; i++)
+        hits += cvec_index_search(ix, &keys[i]) >= 0;
+    report("cvec_index_search", now() - start, base, nlookups, hits);
+
+    hits = 0;
+    start = now();
+    cvec_index_search_many(ix, keys, nlookups, found);
+    elapsed = now() - start;
+    for (int i = 0; i < nlookups; i++)
+        hits += found[i] >= 0;
+    report("cvec_index_search_many", elapsed, base, nlookups, hits);
+
+    cvec_index_dispose(ix);
+    cvec_dispose(cv);
+    free(keys);
+    free(found);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/* File: segvectest.c
+ * ------------------
+ * Exercises the CSegVector: indexing across chunks, stability of element
+ * addresses across appends, and lock-free reading while a writer appends.
+ */
+
+#include "csegvec.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static void verify_int(int expected, int found, char *msg)
+{
+    printf("%s expect: %d found: %d. %s\n", msg, expected, found,
+        (expected == found) ? "Seems ok." : "##### PROBLEM HERE #####");
+}
+
+
+/* Function: simple_segvec
+ * -----------------------
+ * Appends across many small chunks and checks values and that a pointer
+ * taken early still points at the same element at the end.
+ */
+static void simple_segvec()
+{
+    printf("\n----------------- Testing simple segvec ------------------ \n");
+    CSegVector *sv = csegvec_create(sizeof(int), 8, NULL);
+    int zero = 0;
+    int *first = csegvec_append(sv, &zero);
+    for (int i = 1; i < 10000; i++)
+        csegvec_append(sv, &i);
+    verify_int(10000, csegvec_count(sv), "csegvec_count");
+    verify_int(4321, *(int *)csegvec_nth(sv, 4321), "*value for csegvec_nth(4321)");
+    verify_int(1, first == csegvec_nth(sv, 0), "Address of element 0 unchanged");
+    csegvec_dispose(sv);
+}
+
+
+#define NREADERS 4
+#define NAPPENDS 2000000
+
+/* Function: reader
+ * ----------------
+ * Repeatedly checks the most recently published element while the main
+ * thread appends. Each element i holds the value i, so any torn or
+ * unpublished read shows up as a mismatch.
+ */
+static void *reader(void *arg)
+{
+    CSegVector *sv = arg;
+    long bad = 0;
+    int n;
+    while ((n = csegvec_count(sv)) < NAPPENDS) {
+        if (n > 0 && *(int *)csegvec_nth(sv, n - 1) != n - 1) bad++;
+        if (n > 1 && *(int *)csegvec_nth(sv, n / 2) != n / 2) bad++;
+    }
+    return (void *)bad;
+}
+
+static void concurrent_segvec()
+{
+    printf("\n----------------- Testing concurrent readers ------------------ \n");
+    CSegVector *sv = csegvec_create(sizeof(int), 64, NULL);
+    pthread_t readers[NREADERS];
+    for (int i = 0; i < NREADERS; i++)
+        pthread_create(&readers[i], NULL, reader, sv);
+    for (int i = 0; i < NAPPENDS; i++)
+        csegvec_append(sv, &i);
+    long bad = 0;
+    for (int i = 0; i < NREADERS; i++) {
+        void *result;
+        pthread_join(readers[i], &result);
+        bad += (long)result;
+    }
+    verify_int(0, bad, "Bad reads");
+    verify_int(NAPPENDS, csegvec_count(sv), "csegvec_count");
+    csegvec_dispose(sv);
+}
+
+int main(int argc, char *argv[])
+{
+    simple_segvec();
+    concurrent_segvec();
+    return 0;
+}
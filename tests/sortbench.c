@@ -0,0 +1,152 @@
+/* File: sortbench.c
+ * -----------------
+ * Times sorting a CVector of records by a 64-bit key, with cvec_sort (qsort
+ * and a comparison callback) against cvec_sort_keyed (radix sort on the
+ * key bytes) and the CVEC_SORT_DEFINE sorts (comparison inlined), then
+ * with cvec_sort_parallel at 1, 2, 4, ... threads up to
+ * maxthreads (default: one per processor), and checks that every sort
+ * produces the same order of keys. Then times selecting the least
+ * TOPK records with cvec_partial_sort and cvec_topk.
+ * Usage: sortbench [nelems] [maxthreads]
+ */
+
+#include "cvector.h"
+#include "cvector_parallel.h"
+#include "cvector_sort.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_NELEMS 10000000
+#define TOPK 100
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} Record;
+
+CVEC_SORT_DEFINE(recsort, Record, a.key < b.key)
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int cmp_record(const void *p1, const void *p2)
+{
+    uint64_t a = ((const Record *)p1)->key, b = ((const Record *)p2)->key;
+    return (a > b) - (a < b);
+}
+
+/* Function: fill
+ * --------------
+ * Makes a CVector of nelems records with pseudo-random keys, the same
+ * sequence every call.
+ */
+static CVector *fill(int nelems)
+{
+    CVector *cv = cvec_create(sizeof(Record), nelems, NULL);
+    uint64_t x = 88172645463325252ULL; // xorshift64 state
+    for (int i = 0; i < nelems; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        Record r = { x, i };
+        cvec_append(cv, &r);
+    }
+    return cv;
+}
+
+/* Function: check_prefix
+ * ----------------------
+ * Compares the first n keys of a CVector with those of the reference sort
+ * and reports whether they agree.
+ */
+static int check_prefix(const CVector *expected, const CVector *found, int n)
+{
+    int mismatches = 0;
+    for (int i = 0; i < n; i++)
+        if (((Record *)cvec_nth(expected, i))->key != ((Record *)cvec_nth(found, i))->key) mismatches++;
+    printf("  %s\n", mismatches == 0 ? "Same order." : "##### ORDER DIFFERS #####");
+    return mismatches;
+}
+
+/* Function: check_order
+ * ---------------------
+ * Compares the keys of a sorted CVector with those of the reference sort
+ * and reports whether they agree.
+ */
+static int check_order(const CVector *expected, const CVector *found)
+{
+    return check_prefix(expected, found, cvec_count(expected));
+}
+
+int main(int argc, char *argv[])
+{
+    int nelems = (argc > 1) ? atoi(argv[1]) : DEFAULT_NELEMS;
+    printf("Sorting %d 16-byte records by a 64-bit key\n", nelems);
+
+    CVector *a = fill(nelems);
+    double start = now();
+    cvec_sort(a, cmp_record);
+    double qsort_time = now() - start;
+    printf("cvec_sort        %8.3f s\n", qsort_time);
+
+    CVector *b = fill(nelems);
+    start = now();
+    cvec_sort_keyed(b, offsetof(Record, key), sizeof(uint64_t), CVEC_KEY_UNSIGNED);
+    double radix_time = now() - start;
+    printf("cvec_sort_keyed  %8.3f s  (%.1fx)", radix_time, qsort_time / radix_time);
+    int mismatches = check_order(a, b);
+    cvec_dispose(b);
+
+    b = fill(nelems);
+    start = now();
+    recsort_sort(cvec_data(b), nelems);
+    double intro_time = now() - start;
+    printf("recsort_sort     %8.3f s  (%.1fx)", intro_time, qsort_time / intro_time);
+    mismatches += check_order(a, b);
+    cvec_dispose(b);
+
+    b = fill(nelems);
+    start = now();
+    recsort_stable_sort(cvec_data(b), nelems);
+    double stable_time = now() - start;
+    printf("recsort_stable_sort %5.3f s  (%.1fx)", stable_time, qsort_time / stable_time);
+    mismatches += check_order(a, b);
+    cvec_dispose(b);
+
+    int maxthreads = (argc > 2) ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+    for (int t = 1; t <= maxthreads; t = (t * 2 > maxthreads && t < maxthreads) ? maxthreads : t * 2) {
+        CVector *c = fill(nelems);
+        start = now();
+        cvec_sort_parallel(c, cmp_record, t);
+        double par_time = now() - start;
+        printf("cvec_sort_parallel %3d threads  %8.3f s  (%.1fx)", t, par_time, qsort_time / par_time);
+        mismatches += check_order(a, c);
+        cvec_dispose(c);
+    }
+
+    int k = (nelems < TOPK) ? nelems : TOPK;
+    printf("\nSelecting the least %d records\n", k);
+    b = fill(nelems);
+    start = now();
+    cvec_partial_sort(b, k, cmp_record);
+    double partial_time = now() - start;
+    printf("cvec_partial_sort %7.3f s  (%.1fx)", partial_time, qsort_time / partial_time);
+    mismatches += check_prefix(a, b, k);
+    cvec_dispose(b);
+
+    b = fill(nelems);
+    start = now();
+    CVector *top = cvec_topk(b, k, cmp_record);
+    double topk_time = now() - start;
+    printf("cvec_topk        %8.3f s  (%.1fx)", topk_time, qsort_time / topk_time);
+    mismatches += check_prefix(a, top, k);
+    cvec_dispose(top);
+    cvec_dispose(b);
+    cvec_dispose(a);
+    return mismatches != 0;
+}
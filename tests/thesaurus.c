@@ -1,30 +1,23 @@
 /* File: thesaurus.c
  * -----------------
- * A program that uses CVector/CMap to build a thesaurus of synonyms. The CMap
- * associates words with CVectors of other words. The thesaurus file is huge,
- * so this serves as a scalability test.
+ * A program that uses a multimap CMap to build a thesaurus of synonyms. The
+ * CMap associates each word with the list of its synonyms, stored together
+ * with the word. Every word is interned in a CStrPool, so a word that is a
+ * headword and a synonym of dozens of others is stored only once. The
+ * thesaurus file is huge, so this serves as a scalability test.
  * jzelenski, based on earlier program by Jerry Cain
  */
 
 #include <stdio.h>
 #include "cmap.h"
-#include "cvector.h"
+#include "cstrpool.h"
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <error.h>
 
-#define NUM_SYNONYMS 16
 #define NUM_HEADWORDS 35000
-
-static void cleanup_cvec(void *p)
-{
-    cvec_dispose(*(CVector **)p);
-}
-
-static void cleanup_str(void *p)
-{
-    free(*(char **)p);
-}
+#define NUM_WORDS 100000
 
 /**
  * Reads a single line from FILE * using fgets into the client's
@@ -48,13 +41,15 @@ static bool read_line(FILE *fp, char *buf, int sz)
  * The first word (or phrase) is primary, and rest of line are synonyms of first.
  * The ',' delimits words, and the '\n' marks the end of the entry.
  */
-static CMap *read_thesaurus(FILE *fp)
+static CMap *read_thesaurus(FILE *fp, CStrPool *words)
 {
-    CMap *thesaurus = cmap_create(sizeof(CVector *), NUM_HEADWORDS, cleanup_cvec);
+    CMap *thesaurus = cmap_create_multi(sizeof(char *), NUM_HEADWORDS, NULL);
+    cmap_intern_keys(thesaurus, words);
     printf("Loading thesaurus..");
     fflush(stdout);
 
     char line[10000], buffer[128];
+    const char *synonyms[sizeof(line) / 2]; // each synonym takes at least a ',' and a letter
     while (read_line(fp, line, sizeof(line))) { // read one line
         if (line[0] == '#') {               // echo file comment
             printf(" (%s)", line+1);
@@ -63,14 +58,15 @@ static CMap *read_thesaurus(FILE *fp)
         char *cur = line;
         sscanf(line, "%127[^,]", buffer);   // first word of line is headword
         cur += strlen(buffer);
-        CVector *synonyms = cvec_create(sizeof(char *), NUM_SYNONYMS, cleanup_str);
-        cmap_put(thesaurus, buffer, &synonyms);
+        const char *headword = cstrpool_intern(words, buffer);
+        int nsynonyms = 0;
         while (sscanf(cur, ",%127[^,]", buffer) == 1) { // all subsequent words are synonyms
-            char *synonym = strdup(buffer);
-            cvec_append(synonyms, &synonym);
+            synonyms[nsynonyms++] = cstrpool_intern(words, buffer);
             cur += strlen(buffer) + 1;
         }
-        if (cmap_count(thesaurus) % 1000 == 0) {
+        int nheadwords = cmap_count(thesaurus);
+        cmap_put_all(thesaurus, headword, synonyms, nsynonyms); // replaces a repeated headword's list
+        if (cmap_count(thesaurus) != nheadwords && cmap_count(thesaurus) % 1000 == 0) {
             printf(".");
             fflush(stdout);
       }
@@ -91,12 +87,12 @@ static void query(CMap *thesaurus)
         char response[1024];
         printf("\nEnter word (RETURN to exit): ");
         if (!read_line(stdin, response, sizeof(response))) break;
-        CVector **found = (CVector **)cmap_get(thesaurus, response);
+        int nfound;
+        const char **found = cmap_get_all(thesaurus, response, &nfound);
         if (found != NULL) {
-            char **cur = cvec_first(*found);
-            printf("%s: {%s", response, cur ? *cur : "");
-            while (cur && (cur = cvec_next(*found, cur)))
-                printf(", %s", *cur);
+            printf("%s: {%s", response, nfound > 0 ? found[0] : "");
+            for (int i = 1; i < nfound; i++)
+                printf(", %s", found[i]);
             printf("}\n");
         } else {
             printf("Nothing found for \"%s\". Try again.\n", response);
@@ -109,9 +105,11 @@ int main(int argc, char *argv[])
     const char *filename = (argc == 1) ? "/afs/ir/class/cs107/samples/assign3/thesaurus.txt" : argv[1];
     FILE *fp = fopen(filename, "r");
     if (fp == NULL) error(1, 0,"Could not open thesaurus file named \"%s\"", filename);
-    CMap *thesaurus = read_thesaurus(fp);
+    CStrPool *words = cstrpool_create(NUM_WORDS);
+    CMap *thesaurus = read_thesaurus(fp, words);
     query(thesaurus);
     cmap_dispose(thesaurus);
+    cstrpool_dispose(words);
     return 0;
 }
 
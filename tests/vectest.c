@@ -7,16 +7,20 @@
 */
 
 #include "cvector.h"
+#include "cvector_inline.h"
+#include "cvector_typed.h"
+#include "cvector_sort.h"
+#include "cvecindex.h"
 #include <error.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 
-// Uncomment this line to test cvec_remove
-// #define ENABLE_CVEC_REMOVE
-// Uncomment this line to test cvec_replace
-// #define ENABLE_CVEC_REPLACE
+// Comment out this line to skip testing cvec_remove
+#define ENABLE_CVEC_REMOVE
+// Comment out this line to skip testing cvec_replace
+#define ENABLE_CVEC_REPLACE
 
 
 /* Function: verify_int
@@ -31,6 +35,13 @@ static void verify_int(int expected, int found, char *msg)
 }
 
 
+static void verify_ptr(void *expected, void *found, char *msg)
+{
+    printf("%s expect: %p found: %p. %s\n", msg, expected, found,
+        (expected == found) ? "Seems ok." : "##### PROBLEM HERE #####");
+}
+
+
 /* Function: simple_cvec
 * ----------------------
 * Exercises the CVector storing integers. Exercises the operations to
@@ -110,6 +121,18 @@ static int cmp_char(const void *p1, const void *p2)
 }
 
 
+/* Function: cmp_initial
+* ---------------------
+* Comparator in the bsearch style, whose key is of a different type than
+* the elements: compares a word (passed as a char **) to a char element
+* by its first letter.
+*/
+static int cmp_initial(const void *key, const void *elem)
+{
+    return (**(char **)key - *(char *)elem);
+}
+
+
 /* Function: sortsearch_test
 * --------------------------
 * Exercises the CVector storing chars. Tests sort, linear and binary search.
@@ -140,17 +163,612 @@ static void sortsearch_test()
     verify_int(20, cvec_search(cv, &alphabet[20], cmp_char, 10, true), "Binary search");
     verify_int(20, cvec_search(cv, &alphabet[20], cmp_char, 10, false), "Linear search");
     verify_int(-1, cvec_search(cv, &ch, cmp_char, 10, true), "Binary search");
+    char *word = "umbrella";
+    verify_int(20, cvec_search(cv, &word, cmp_initial, 0, true), "Binary search, key of another type");
     cvec_dispose(cv);
 }
 
 
 
+/* Function: growth_test
+* ----------------------
+* Exercises growth policies, cvec_reserve and cvec_shrink_to_fit.
+*/
+static void growth_test()
+{
+    printf("\n----------------- Testing growth policies ------------------ \n");
+    CVector *half = cvec_create_growth(sizeof(int), 4, NULL, CVEC_GROW_HALF, 0);
+    CVector *chunk = cvec_create_growth(sizeof(int), 4, NULL, CVEC_GROW_CHUNK, 10);
+    for (int i = 0; i < 5; i++) {
+        cvec_append(half, &i);
+        cvec_append(chunk, &i);
+    }
+    verify_int(7, cvec_capacity(half), "Capacity after 1.5x growth");
+    verify_int(14, cvec_capacity(chunk), "Capacity after chunk growth");
+
+    cvec_reserve(half, 1000);
+    verify_int(1000, cvec_capacity(half), "Capacity after reserve");
+    cvec_reserve(half, 10);
+    verify_int(1000, cvec_capacity(half), "Reserve never shrinks");
+    cvec_shrink_to_fit(half);
+    verify_int(5, cvec_capacity(half), "Capacity after shrink_to_fit");
+    verify_int(4, *(int *)cvec_nth(half, 4), "*value for cvec_nth(4)");
+    cvec_remove_range(half, 0, 3);
+    cvec_shrink_to_fit(half);                 // back into the inline buffer
+    verify_int(4, cvec_capacity(half), "Capacity after shrink to inline");
+    verify_int(4, *(int *)cvec_nth(half, 1), "*value for cvec_nth(1)");
+    cvec_dispose(half);
+    cvec_dispose(chunk);
+}
+
+
+/* Function: bulk_test
+* --------------------
+* Exercises the range operations: append_many, insert_range, remove_range.
+*/
+static void bulk_test()
+{
+    printf("\n----------------- Testing bulk range ops ------------------ \n");
+    int nums[100];
+    for (int i = 0; i < 100; i++)
+        nums[i] = i;
+    CVector *cv = cvec_create(sizeof(int), 4, NULL);
+    cvec_append_many(cv, nums, 50);                 // 0..49
+    cvec_append_many(cv, nums + 50, 50);            // 0..99
+    verify_int(100, cvec_count(cv), "cvec_count");
+    verify_int(99, *(int *)cvec_nth(cv, 99), "*value for cvec_nth(99)");
+
+    cvec_insert_range(cv, nums, 3, 10);             // 0..9|0|1|2|10..99
+    verify_int(103, cvec_count(cv), "cvec_count");
+    verify_int(2, *(int *)cvec_nth(cv, 12), "*value for cvec_nth(12)");
+    verify_int(10, *(int *)cvec_nth(cv, 13), "*value for cvec_nth(13)");
+
+    cvec_remove_range(cv, 10, 3);                   // 0..99
+    cvec_remove_range(cv, 0, 90);                   // 90..99
+    verify_int(10, cvec_count(cv), "cvec_count");
+    verify_int(90, *(int *)cvec_nth(cv, 0), "*value for cvec_nth(0)");
+    cvec_remove_range(cv, 0, cvec_count(cv));
+    verify_int(0, cvec_count(cv), "cvec_count");
+    cvec_dispose(cv);
+}
+
+
+/* Function: inline_test
+* ----------------------
+* Checks that the inline accessors agree with the out-of-line functions.
+*/
+static void inline_test()
+{
+    printf("\n----------------- Testing inline accessors ------------------ \n");
+    CVector *cv = cvec_create(sizeof(int), 0, NULL);
+    verify_ptr(NULL, cvec_first_inline(cv), "cvec_first_inline on empty");
+    for (int i = 0; i < 100; i++)
+        cvec_append(cv, &i);
+    verify_int(cvec_count(cv), cvec_count_inline(cv), "cvec_count_inline");
+    verify_ptr(cvec_nth(cv, 42), cvec_nth_inline(cv, 42), "cvec_nth_inline(42)");
+    verify_ptr(cvec_data(cv), cvec_first_inline(cv), "cvec_data vs cvec_first_inline");
+
+    int n = 0, sum = 0;
+    for (int *cur = cvec_first_inline(cv); cur != NULL; cur = cvec_next_inline(cv, cur), n++)
+        sum += *cur;
+    verify_int(100, n, "Elements iterated");
+    int *nums = cvec_data_inline(cv), total = 0;
+    for (int i = 0; i < cvec_count_inline(cv); i++)
+        total += nums[i];
+    verify_int(sum, total, "Sum through cvec_data_inline");
+    cvec_dispose(cv);
+}
+
+
+CVECTOR_DEFINE(intvec, int)
+
+/* Function: typed_test
+* ---------------------
+* Exercises a vector generated by CVECTOR_DEFINE.
+*/
+static void typed_test()
+{
+    printf("\n----------------- Testing typed vector ------------------ \n");
+    intvec *v = intvec_create(2, NULL);
+    for (int i = 0; i < 1000; i++)
+        intvec_append(v, i);
+    verify_int(1000, intvec_count(v), "intvec_count");
+    intvec_insert(v, -1, 0);
+    intvec_remove(v, 500);                         // -1|0..498|500..999
+    verify_int(-1, *intvec_nth(v, 0), "*value for intvec_nth(0)");
+    verify_int(500, *intvec_nth(v, 500), "*value for intvec_nth(500)");
+
+    long sum = 0;
+    int *data = intvec_data(v);
+    for (int i = 0; i < intvec_count(v); i++)
+        sum += data[i];
+    verify_int(999*1000/2 - 1 - 499, sum, "Sum of elements");
+    intvec_dispose(v);
+}
+
+
 static int cmp_int(const void *p1, const void *p2)
 {
     return (*(int *)p1) - (*(int *)p2);
 }
 
 
+/* Function: deque_test
+* ---------------------
+* Uses a CVector as a double-ended queue so that its elements wrap around
+* the end of storage, then checks indexing, spans, iteration, growth,
+* search and sort on the wrapped vector.
+*/
+static void deque_test()
+{
+    printf("\n----------------- Testing deque ops ------------------ \n");
+    CVector *cv = cvec_create(sizeof(int), 8, NULL);
+    for (int i = 0; i < 5; i++)
+        cvec_append(cv, &i);                         // 0..4
+    for (int i = -1; i >= -3; i--)
+        cvec_push_front(cv, &i);                     // -3..4
+    verify_int(8, cvec_count(cv), "cvec_count");
+    verify_int(-3, *(int *)cvec_nth(cv, 0), "*value for cvec_nth(0)");
+    verify_int(4, *(int *)cvec_nth(cv, 7), "*value for cvec_nth(7)");
+    verify_int(-1, *(int *)cvec_nth_inline(cv, 2), "*value for cvec_nth_inline(2)");
+
+    CVecSpan spans[2];
+    int nspans = cvec_span(cv, spans);
+    verify_int(2, nspans, "cvec_span count");
+    verify_int(8, spans[0].count + spans[1].count, "Elements in spans");
+    verify_int(-3, *(int *)spans[0].data, "*value at spans[0]");
+
+    int n = 0, expect = -3, inorder = 1;
+    for (int *cur = cvec_first(cv); cur != NULL; cur = cvec_next(cv, cur), n++)
+        if (*cur != expect++) inorder = 0;
+    verify_int(8, n, "Elements iterated");
+    verify_int(1, inorder, "Iterated in index order");
+    n = 0;
+    for (int *cur = cvec_first_inline(cv); cur != NULL; cur = cvec_next_inline(cv, cur))
+        n++;
+    verify_int(8, n, "Elements iterated inline");
+    verify_int(6, cvec_search(cv, &(int){3}, cmp_int, 0, true), "Search wrapped, sorted");
+    verify_int(1, cvec_search(cv, &(int){-2}, cmp_int, 0, false), "Search wrapped, unsorted");
+
+    int val;
+    cvec_pop_front(cv, &val);
+    verify_int(-3, val, "cvec_pop_front");
+    cvec_pop_back(cv, &val);
+    verify_int(4, val, "cvec_pop_back");           // -2..3
+
+    // growing a wrapped vector keeps index order
+    for (int i = -3; i >= -20; i--)
+        cvec_push_front(cv, &i);                     // -20..3
+    verify_int(24, cvec_count(cv), "cvec_count");
+    verify_int(-20, *(int *)cvec_nth(cv, 0), "*value for cvec_nth(0)");
+    verify_int(3, *(int *)cvec_nth(cv, 23), "*value for cvec_nth(23)");
+
+    // sliding window: every step pops the oldest and pushes the newest
+    for (int i = 4; i < 1000; i++) {
+        cvec_pop_front(cv, NULL);
+        cvec_append(cv, &i);
+    }
+    verify_int(24, cvec_count(cv), "Window size");
+    verify_int(976, *(int *)cvec_nth(cv, 0), "*value for cvec_nth(0)");
+    verify_int(1, cvec_capacity(cv) < 64, "Window did not keep growing");
+
+    // removing a suffix of a wrapped vector leaves it wrapped
+    verify_int(2, cvec_span(cv, spans), "Window wraps");
+    cvec_remove_range(cv, 20, 4);                   // 976..995
+    verify_int(2, cvec_span(cv, spans), "Still wraps after removing suffix");
+    verify_int(995, *(int *)cvec_nth(cv, 19), "*value for cvec_nth(19)");
+    for (int i = 996; i < 1000; i++)
+        cvec_append(cv, &i);
+
+    cvec_push_front(cv, &(int){2000});
+    cvec_sort(cv, cmp_int);
+    verify_int(2000, *(int *)cvec_nth(cv, 24), "Largest sorted last");
+    int *nums = cvec_data(cv);
+    verify_int(976, nums[0], "cvec_data()[0]");
+    verify_int(999, nums[23], "cvec_data()[23]");
+    cvec_dispose(cv);
+}
+
+
+/* Function: keyed_test
+* ---------------------
+* Sorts records by keys of each kind and width with cvec_sort_keyed and
+* checks the order, and that equal keys keep their previous order.
+*/
+typedef struct {
+    int id;
+    double score;
+    short bucket;
+    unsigned char tag;
+} Record;
+
+static void keyed_test(int n)
+{
+    printf("\n----------------- Testing keyed radix sort (%d) ------------------ \n", n);
+    CVector *cv = cvec_create(sizeof(Record), 0, NULL);
+    srand(n);
+    for (int i = 0; i < n; i++) {
+        Record r = { i, (rand() - RAND_MAX / 2) / 1000.0, rand() % 50 - 25, rand() };
+        cvec_append(cv, &r);
+    }
+    Record neg_zero = { n, -0.0, 0, 0 };
+    cvec_push_front(cv, &neg_zero);                 // sorts a wrapped vector too
+
+    int ok = 1;
+    cvec_sort_keyed(cv, offsetof(Record, score), sizeof(double), CVEC_KEY_FLOAT);
+    for (int i = 1; i < cvec_count(cv); i++)
+        if (((Record *)cvec_nth(cv, i - 1))->score > ((Record *)cvec_nth(cv, i))->score) ok = 0;
+    verify_int(1, ok, "Ascending by double score");
+
+    cvec_sort_keyed(cv, offsetof(Record, id), sizeof(int), CVEC_KEY_SIGNED);
+    verify_int(n, ((Record *)cvec_nth(cv, n))->id, "Largest id sorted last");
+    cvec_sort_keyed(cv, offsetof(Record, bucket), sizeof(short), CVEC_KEY_SIGNED);
+    for (int i = 1; i < cvec_count(cv); i++) {
+        Record *a = cvec_nth(cv, i - 1), *b = cvec_nth(cv, i);
+        if (a->bucket > b->bucket || (a->bucket == b->bucket && a->id > b->id)) ok = 0;
+    }
+    verify_int(1, ok, "Ascending by short bucket, stable by id");
+
+    cvec_sort_keyed(cv, offsetof(Record, tag), 1, CVEC_KEY_UNSIGNED);
+    for (int i = 1; i < cvec_count(cv); i++)
+        if (((Record *)cvec_nth(cv, i - 1))->tag > ((Record *)cvec_nth(cv, i))->tag) ok = 0;
+    verify_int(1, ok, "Ascending by unsigned char tag");
+
+    // a 3-byte key takes the comparison fallback; on a little-endian
+    // machine bytes 16..18 read as tag * 65536 + (unsigned short)bucket
+    cvec_sort_keyed(cv, offsetof(Record, id), sizeof(int), CVEC_KEY_SIGNED);
+    cvec_sort_keyed(cv, offsetof(Record, bucket), 3, CVEC_KEY_UNSIGNED);
+    for (int i = 1; i < cvec_count(cv); i++) {
+        Record *a = cvec_nth(cv, i - 1), *b = cvec_nth(cv, i);
+        long ka = a->tag * 65536L + (unsigned short)a->bucket, kb = b->tag * 65536L + (unsigned short)b->bucket;
+        if (ka > kb || (ka == kb && a->id > b->id)) ok = 0;
+    }
+    verify_int(1, ok, "Ascending by 3-byte key, stable by id");
+    cvec_dispose(cv);
+}
+
+
+/* Function: generated_sort_test
+* ------------------------------
+* Checks the CVEC_SORT_DEFINE sorts against cvec_sort on random, sorted,
+* reversed, nearly sorted, and all-equal input, and the stable sort's
+* handling of equal keys.
+*/
+CVEC_SORT_DEFINE(intsort, int, a < b)
+CVEC_SORT_DEFINE(recsort, Record, a.bucket < b.bucket)
+
+static void generated_sort_test(int n)
+{
+    printf("\n----------------- Testing generated sorts (%d) ------------------ \n", n);
+    const char *names[] = { "random", "sorted", "reversed", "nearly sorted", "all equal" };
+    srand(n);
+    for (int pattern = 0; pattern < 5; pattern++) {
+        CVector *expected = cvec_create(sizeof(int), n, NULL);
+        for (int i = 0; i < n; i++) {
+            int val = (pattern == 0) ? rand() : (pattern == 1) ? i : (pattern == 2) ? n - i : (pattern == 3) ? i + (rand() % 100 == 0) * 50 : 7;
+            cvec_append(expected, &val);
+        }
+        int *copy = malloc(n * sizeof(int)), *copy2 = malloc(n * sizeof(int));
+        memcpy(copy, cvec_data(expected), n * sizeof(int));
+        memcpy(copy2, copy, n * sizeof(int));
+        cvec_sort(expected, cmp_int);
+        intsort_sort(copy, n);
+        intsort_stable_sort(copy2, n);
+        char msg[64];
+        sprintf(msg, "intsort_sort %s", names[pattern]);
+        verify_int(0, memcmp(cvec_data(expected), copy, n * sizeof(int)), msg);
+        sprintf(msg, "intsort_stable_sort %s", names[pattern]);
+        verify_int(0, memcmp(cvec_data(expected), copy2, n * sizeof(int)), msg);
+        free(copy);
+        free(copy2);
+        cvec_dispose(expected);
+    }
+
+    Record *recs = malloc(n * sizeof(Record));
+    for (int i = 0; i < n; i++)
+        recs[i] = (Record){ i, 0, rand() % 10, 0 };
+    recsort_stable_sort(recs, n);
+    int ok = 1;
+    for (int i = 1; i < n; i++)
+        if (recs[i - 1].bucket > recs[i].bucket || (recs[i - 1].bucket == recs[i].bucket && recs[i - 1].id > recs[i].id)) ok = 0;
+    verify_int(1, ok, "recsort_stable_sort keeps equal keys in order");
+    free(recs);
+}
+
+
+/* Function: find_eq_test
+* -----------------------
+* Checks cvec_find_eq against a plain loop for every supported width and
+* an odd one, at every start index, with the match placed in vector
+* bodies and scalar tails, and on a wrapped vector.
+*/
+static int naive_find(const CVector *cv, const void *key, size_t elemsz, int start)
+{
+    for (int i = start; i < cvec_count(cv); i++)
+        if (memcmp(cvec_nth(cv, i), key, elemsz) == 0) return i;
+    return -1;
+}
+
+static void find_eq_test()
+{
+    printf("\n----------------- Testing cvec_find_eq ------------------ \n");
+    size_t widths[] = { 1, 2, 4, 8, 3 };
+    int mismatches = 0;
+    for (int w = 0; w < 5; w++) {
+        size_t elemsz = widths[w];
+        unsigned char elem[8] = { 0 }, key[8] = { 0 };
+        CVector *cv = cvec_create(elemsz, 0, NULL);
+        for (int i = 0; i < 150; i++) {
+            memset(elem, i % 37 == 5 ? 0xAB : i & 0x7f, elemsz);
+            cvec_append(cv, elem);
+        }
+        memset(key, 0xAB, elemsz);
+        for (int start = 0; start <= cvec_count(cv); start++)
+            if (cvec_find_eq(cv, key, start) != naive_find(cv, key, elemsz, start)) mismatches++;
+        memset(key, 0xEE, elemsz);
+        if (cvec_find_eq(cv, key, 0) != -1) mismatches++;
+        // wrap the vector and search across the seam
+        for (int i = 0; i < 40; i++) {
+            cvec_pop_back(cv, elem);
+            cvec_push_front(cv, elem);
+        }
+        CVecSpan spans[2];
+        if (cvec_span(cv, spans) != 2) mismatches++;
+        memset(key, 0xAB, elemsz);
+        for (int start = 0; start <= cvec_count(cv); start++)
+            if (cvec_find_eq(cv, key, start) != naive_find(cv, key, elemsz, start)) mismatches++;
+        cvec_dispose(cv);
+    }
+    verify_int(0, mismatches, "Mismatches against a plain loop");
+}
+
+
+/* Function: index_test
+* ---------------------
+* Builds a CVecIndex over sorted ints with runs of duplicates and checks
+* single and batched searches against cvec_search, for every size up to
+* a few complete tree levels and for keys present and absent.
+*/
+static void index_test()
+{
+    printf("\n----------------- Testing CVecIndex ------------------ \n");
+    int mismatches = 0;
+    for (int n = 0; n <= 70; n++) {
+        CVector *cv = cvec_create(sizeof(int), 0, NULL);
+        for (int i = 0; i < n; i++) {
+            int val = 2 * (i / 3);                  // 0,0,0,2,2,2,...: odd keys are absent
+            cvec_append(cv, &val);
+        }
+        CVecIndex *ix = cvec_index_create(cv, cmp_int);
+        int keys[60], found[60];
+        for (int key = -1; key < 59; key++) {
+            keys[key + 1] = key;
+            if (cvec_index_search(ix, &key) != cvec_search(cv, &key, cmp_int, 0, true)) mismatches++;
+        }
+        cvec_index_search_many(ix, keys, 60, found);
+        for (int i = 0; i < 60; i++)
+            if (found[i] != cvec_search(cv, &keys[i], cmp_int, 0, true)) mismatches++;
+        cvec_index_dispose(ix);
+        cvec_dispose(cv);
+    }
+    verify_int(0, mismatches, "Mismatches against cvec_search");
+
+    // cvec_search_many with sorted and unsorted keys, on a wrapped vector
+    CVector *sorted = cvec_create(sizeof(int), 0, NULL);
+    for (int i = 999; i >= 0; i--) {
+        int val = 3 * (i / 2);
+        cvec_push_front(sorted, &val);
+    }
+    int keys[500], found[500];
+    mismatches = 0;
+    for (int i = 0; i < 500; i++)
+        keys[i] = i * 3 - 7;                         // ascending, some below the first element
+    cvec_search_many(sorted, keys, 500, cmp_int, found);
+    for (int i = 0; i < 500; i++)
+        if (found[i] != cvec_search(sorted, &keys[i], cmp_int, 0, true)) mismatches++;
+    for (int i = 0; i < 500; i++)
+        keys[i] = (i * 7919) % 1600 - 10;            // scrambled, with repeats and misses
+    cvec_search_many(sorted, keys, 500, cmp_int, found);
+    for (int i = 0; i < 500; i++)
+        if (found[i] != cvec_search(sorted, &keys[i], cmp_int, 0, true)) mismatches++;
+    verify_int(0, mismatches, "cvec_search_many mismatches against cvec_search");
+    verify_int(-1, found[0], "Missing key gives -1");
+    cvec_dispose(sorted);
+
+    int zero = 0;
+    CVector *cv = cvec_create(sizeof(int), 0, NULL);
+    for (int i = 0; i < 5; i++)
+        cvec_append(cv, &zero);
+    verify_int(0, cvec_search(cv, &zero, cmp_int, 0, true), "cvec_search finds first duplicate");
+    cvec_dispose(cv);
+}
+
+
+/* Function: bounds_test
+* ----------------------
+* Checks lower bound, upper bound and equal range against a linear scan
+* on wrapped vectors with runs of duplicates, then builds an ordered set
+* and multiset with cvec_insert_sorted.
+*/
+static void bounds_test()
+{
+    printf("\n----------------- Testing sorted bounds ------------------ \n");
+    int mismatches = 0;
+    for (int n = 0; n <= 40; n++) {
+        CVector *cv = cvec_create(sizeof(int), 0, NULL);
+        for (int i = n - 1; i >= 0; i--) {
+            int val = 2 * (i / 3);                  // 0,0,0,2,2,2,...: odd keys are absent
+            cvec_push_front(cv, &val);               // wraps around storage
+        }
+        for (int key = -1; key < 30; key++) {
+            int lo = 0, hi = 0;
+            while (lo < n && *(int *)cvec_nth(cv, lo) < key) lo++;
+            while (hi < n && *(int *)cvec_nth(cv, hi) <= key) hi++;
+            int first, last;
+            if (cvec_lower_bound(cv, &key, cmp_int) != lo) mismatches++;
+            if (cvec_upper_bound(cv, &key, cmp_int) != hi) mismatches++;
+            if (cvec_equal_range(cv, &key, cmp_int, &first, &last) != hi - lo) mismatches++;
+            if (first != lo || last != hi) mismatches++;
+        }
+        cvec_dispose(cv);
+    }
+    verify_int(0, mismatches, "Mismatches against linear scan");
+
+    // build an ordered set and an ordered multiset from scrambled input
+    CVector *set = cvec_create(sizeof(int), 0, NULL);
+    CVector *multi = cvec_create(sizeof(int), 0, NULL);
+    int refused = 0;
+    for (int i = 0; i < 300; i++) {
+        int val = (i * 37) % 100;                    // each of 0..99 three times
+        if (cvec_insert_sorted(set, &val, cmp_int, true) == -1) refused++;
+        int index = cvec_insert_sorted(multi, &val, cmp_int, false);
+        if (*(int *)cvec_nth(multi, index) != val) mismatches++;
+    }
+    verify_int(100, cvec_count(set), "Set count");
+    verify_int(200, refused, "Duplicates refused");
+    verify_int(300, cvec_count(multi), "Multiset count");
+    for (int i = 0; i < 300; i++) {
+        if (i < 100 && *(int *)cvec_nth(set, i) != i) mismatches++;
+        if (*(int *)cvec_nth(multi, i) != i / 3) mismatches++;
+    }
+    verify_int(0, mismatches, "Out of order elements");
+    verify_int(3, cvec_equal_range(multi, &(int){42}, cmp_int, NULL, NULL), "Run of 42s");
+    verify_int(-1, cvec_insert_sorted(set, &(int){42}, cmp_int, true), "Insert duplicate into set");
+    verify_int(0, cvec_insert_sorted(set, &(int){-5}, cmp_int, true), "Insert at front");
+    verify_int(101, cvec_insert_sorted(set, &(int){500}, cmp_int, true), "Insert at back");
+    cvec_dispose(set);
+    cvec_dispose(multi);
+}
+
+
+/* Function: selection_test
+* -------------------------
+* Checks cvec_nth_element, cvec_partial_sort and cvec_topk on a wrapped
+* vector with many duplicates against a fully sorted copy.
+*/
+static int cmp_int_desc(const void *p1, const void *p2)
+{
+    return cmp_int(p2, p1);
+}
+
+static void selection_test(int n)
+{
+    printf("\n----------------- Testing selection on %d elements ------------------ \n", n);
+    CVector *sorted = cvec_create(sizeof(int), n, NULL);
+    CVector *cv = cvec_create(sizeof(int), n, NULL);
+    for (int i = 0; i < n; i++) {
+        int val = rand() % (n / 2 + 1);              // plenty of duplicates
+        cvec_append(sorted, &val);
+        cvec_push_front(cv, &val);                   // wraps around storage
+    }
+    cvec_sort(sorted, cmp_int);
+
+    int mismatches = 0;
+    int picks[] = { 0, n / 3, n / 2, n - 1 };
+    for (int p = 0; p < 4; p++) {
+        int nth = picks[p];
+        cvec_nth_element(cv, nth, cmp_int);
+        int pivot = *(int *)cvec_nth(cv, nth);
+        if (pivot != *(int *)cvec_nth(sorted, nth)) mismatches++;
+        for (int i = 0; i < n; i++) {
+            int val = *(int *)cvec_nth(cv, i);
+            if ((i < nth && val > pivot) || (i > nth && val < pivot)) mismatches++;
+        }
+    }
+    verify_int(0, mismatches, "cvec_nth_element mismatches");
+
+    int k = n < 100 ? n / 2 : 100;
+    cvec_partial_sort(cv, k, cmp_int);
+    for (int i = 0; i < k; i++)
+        if (*(int *)cvec_nth(cv, i) != *(int *)cvec_nth(sorted, i)) mismatches++;
+    verify_int(0, mismatches, "cvec_partial_sort mismatches");
+
+    CVector *top = cvec_topk(cv, k, cmp_int_desc);
+    verify_int(k, cvec_count(top), "cvec_topk count");
+    for (int i = 0; i < k; i++)
+        if (*(int *)cvec_nth(top, i) != *(int *)cvec_nth(sorted, n - 1 - i)) mismatches++;
+    verify_int(0, mismatches, "cvec_topk mismatches");
+    cvec_dispose(top);
+
+    top = cvec_topk(cv, n + 5, cmp_int);
+    verify_int(n, cvec_count(top), "cvec_topk count with k past count");
+    cvec_dispose(top);
+    cvec_dispose(sorted);
+    cvec_dispose(cv);
+}
+
+
+/* Function: sorted_input_selection_test
+* --------------------------------------
+* Runs selection on descending and all-equal input, the cases a poor
+* pivot choice or partition would handle badly.
+*/
+static void sorted_input_selection_test()
+{
+    printf("\n----------------- Testing selection on ordered input ------------------ \n");
+    CVector *cv = cvec_create(sizeof(int), 0, NULL);
+    for (int i = 0; i < 10000; i++)
+        cvec_append(cv, &(int){ 10000 - i });        // descending
+    cvec_nth_element(cv, 1234, cmp_int);
+    verify_int(1235, *(int *)cvec_nth(cv, 1234), "*value for cvec_nth(1234) after nth_element");
+    for (int i = 0; i < 10000; i++)
+        cvec_replace(cv, &(int){ 7 }, i);            // all equal
+    cvec_partial_sort(cv, 10000, cmp_int);
+    verify_int(7, *(int *)cvec_nth(cv, 9999), "*value for cvec_nth(9999) after partial_sort");
+    cvec_dispose(cv);
+}
+
+
+/* Function: heap_test
+* --------------------
+* Checks the binary or 4-ary heap operations: every pop during a mix of
+* pushes and pops returns the true maximum, and a heapified wrapped
+* vector drains in descending order.
+*/
+static void heap_test(int arity)
+{
+    printf("\n----------------- Testing %d-ary heap ------------------ \n", arity);
+    void (*push)(CVector *, const void *, CompareFn) = (arity == 2) ? cvec_heap_push : cvec_heap4_push;
+    void (*pop)(CVector *, void *, CompareFn) = (arity == 2) ? cvec_heap_pop : cvec_heap4_pop;
+    void (*heapify)(CVector *, CompareFn) = (arity == 2) ? cvec_heapify : cvec_heapify4;
+
+    // interleave pushes and pops, checking each pop against the true maximum
+    CVector *heap = cvec_create(sizeof(int), 4, NULL);
+    CVector *shadow = cvec_create(sizeof(int), 0, NULL);
+    int mismatches = 0, val;
+    for (int i = 0; i < 5000; i++) {
+        val = rand() % 1000;
+        if (i % 3 == 2) {
+            pop(heap, &val, cmp_int);
+            cvec_sort(shadow, cmp_int);
+            if (val != *(int *)cvec_nth(shadow, cvec_count(shadow) - 1)) mismatches++;
+            cvec_pop_back(shadow, NULL);
+        } else {
+            push(heap, &val, cmp_int);
+            cvec_append(shadow, &val);
+        }
+    }
+    verify_int(cvec_count(shadow), cvec_count(heap), "Heap count");
+    verify_int(0, mismatches, "Pops that were not the maximum");
+    cvec_dispose(shadow);
+
+    // heapify a wrapped vector, then drain it in descending order
+    for (int i = 0; i < 777; i++)
+        cvec_push_front(heap, &(int){ rand() % 500 });
+    heapify(heap, cmp_int);
+    int prev = *(int *)cvec_nth(heap, 0), n = 0;
+    while (cvec_count(heap) > 0) {
+        pop(heap, &val, cmp_int);
+        if (val > prev) mismatches++;
+        prev = val;
+        n++;
+    }
+    verify_int(0, mismatches, "Drained out of order");
+    verify_int(777 + 5000 - 2 * (5000 / 3), n, "Elements drained");
+    cvec_dispose(heap);
+}
+
+
 /* Function: large_test
 * ---------------------
 * Generate a large CVector of ints. Uses a small allocation
@@ -168,7 +786,6 @@ static void large_test(int size)
     for (int i = 0; i < size; i++)
         cvec_insert(cv, &i, rand() % (cvec_count(cv) + 1)); // insert i at random index
 
-    /*
 #ifdef ENABLE_CVEC_REMOVE
     printf("Deleting all odd numbers.\n");
     for (int i = 1; i < size; i+= 2)	{ // loop by 2
@@ -184,7 +801,6 @@ static void large_test(int size)
             break; // stop at first sign of trouble
         }
     }
-    */
 
     printf("Sorting CVector.\n");
     cvec_sort(cv, cmp_int);
@@ -202,6 +818,23 @@ int main(int argc, char *argv[])
 {
     simple_cvec();
     sortsearch_test();
-    // large_test(25000);
+    growth_test();
+    bulk_test();
+    typed_test();
+    inline_test();
+    deque_test();
+    keyed_test(40);
+    keyed_test(100000);
+    generated_sort_test(10);
+    generated_sort_test(100000);
+    find_eq_test();
+    index_test();
+    bounds_test();
+    selection_test(15);
+    selection_test(50000);
+    sorted_input_selection_test();
+    heap_test(2);
+    heap_test(4);
+    large_test(25000);
     return 0;
 }